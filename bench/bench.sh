@@ -106,6 +106,18 @@ echo -n ","
 echo -n $(${CODON} run -release ${BENCH_DIR}/primes/primes.codon 30000 | tail -n 1)
 echo ""
 
+# ALLOC
+echo -n "alloc"
+echo -n ","
+# nothing for python
+echo -n ","
+# nothing for pypy
+echo -n ","
+# nothing for cpp
+echo -n ","
+echo -n $(${CODON} run -release ${BENCH_DIR}/alloc/alloc.codon | tail -n 1)
+echo ""
+
 # BINARY_TREES
 echo -n "binary_trees"
 echo -n ","
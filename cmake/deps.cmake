@@ -86,6 +86,7 @@ CPMAddPackage(
             "enable_threads ON"
             "enable_large_config ON"
             "enable_thread_local_alloc ON"
+            "enable_parallel_mark ON"
             "enable_handle_fork ON")
 if(bdwgc_ADDED)
     set_target_properties(cord PROPERTIES EXCLUDE_FROM_ALL ON)
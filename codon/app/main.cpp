@@ -11,6 +11,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "codon/cir/transform/cleanup/alloc_demote.h"
 #include "codon/compiler/compiler.h"
 #include "codon/compiler/error.h"
 #include "codon/compiler/jit.h"
@@ -167,6 +168,12 @@ std::unique_ptr<codon::Compiler> processSource(
                      "Python semantics: mirrors Python but might disable optimizations "
                      "like vectorization")),
       llvm::cl::init(C));
+  llvm::cl::opt<bool> vectorizeReport(
+      "vectorize-report",
+      llvm::cl::desc("Report which loops were vectorized, and why others were not"));
+  llvm::cl::opt<bool> allocReport(
+      "alloc-report",
+      llvm::cl::desc("Report which object allocations were moved to the stack"));
 
   llvm::cl::ParseCommandLineOptions(args.size(), args.data());
   initLogFlags(log);
@@ -196,6 +203,11 @@ std::unique_ptr<codon::Compiler> processSource(
       args[0], isDebug, disabledOptsVec,
       /*isTest=*/false, (numerics == Numerics::Python), pyExtension());
   compiler->getLLVMVisitor()->setStandalone(standalone);
+  compiler->getLLVMVisitor()->setVectorizeReport(vectorizeReport);
+  using codon::ir::transform::cleanup::AllocationDemotionPass;
+  if (auto *demotion = dynamic_cast<AllocationDemotionPass *>(
+          compiler->getPassManager()->getPass(AllocationDemotionPass::KEY)))
+    demotion->setRemarks(allocReport);
 
   // load plugins
   for (const auto &plugin : plugins) {
@@ -323,6 +335,16 @@ int buildMode(const std::vector<const char *> &args, const std::string &argv0) {
       "l", llvm::cl::desc("Link the specified library (only for executables)"));
   llvm::cl::opt<std::string> lflags("linker-flags",
                                     llvm::cl::desc("Pass given flags to linker"));
+  llvm::cl::opt<codon::ir::LTOMode> lto(
+      "lto",
+      llvm::cl::desc("link-time optimization (only for executables and libraries)"),
+      llvm::cl::values(
+          clEnumValN(codon::ir::NO_LTO, "none", "Link native object code"),
+          clEnumValN(codon::ir::THIN_LTO, "thin",
+                     "Link bitcode with ThinLTO; allows inlining of calls into "
+                     "bitcode objects passed via -linker-flags"),
+          clEnumValN(codon::ir::FULL_LTO, "full", "Link bitcode with monolithic LTO")),
+      llvm::cl::init(codon::ir::NO_LTO));
   llvm::cl::opt<BuildKind> buildKind(
       llvm::cl::desc("output type"),
       llvm::cl::values(
@@ -349,6 +371,7 @@ int buildMode(const std::vector<const char *> &args, const std::string &argv0) {
   if (!compiler)
     return EXIT_FAILURE;
   std::vector<std::string> libsVec(libs);
+  compiler->getLLVMVisitor()->setLTO(lto);
 
   if (output.empty() && compiler->getInput() == "-")
     codon::compilationError("output file must be specified when reading from stdin");
@@ -72,7 +72,7 @@ LLVMVisitor::LLVMVisitor()
     : util::ConstVisitor(), context(std::make_unique<llvm::LLVMContext>()), M(),
       B(std::make_unique<llvm::IRBuilder<>>(*context)), func(nullptr), block(nullptr),
       value(nullptr), vars(), funcs(), coro(), loops(), trycatch(), catches(), db(),
-      plugins(nullptr) {
+      plugins(nullptr), lto(NO_LTO), vectorizeReport(false) {
   llvm::InitializeAllTargets();
   llvm::InitializeAllTargetMCs();
   llvm::InitializeAllAsmPrinters();
@@ -350,9 +350,10 @@ void LLVMVisitor::process(const Node *x) {
 
 void LLVMVisitor::dump(const std::string &filename) { writeToLLFile(filename, false); }
 
-void LLVMVisitor::runLLVMPipeline() {
+void LLVMVisitor::runLLVMPipeline(bool preLink) {
   db.builder->finalize();
-  optimize(M.get(), db.debug, db.jit, plugins);
+  optimize(M.get(), db.debug, db.jit, plugins, preLink ? lto : NO_LTO,
+           vectorizeReport);
 }
 
 void LLVMVisitor::writeToObjectFile(const std::string &filename, bool pic) {
@@ -382,10 +383,16 @@ void LLVMVisitor::writeToObjectFile(const std::string &filename, bool pic) {
 }
 
 void LLVMVisitor::writeToBitcodeFile(const std::string &filename) {
-  runLLVMPipeline();
+  runLLVMPipeline(/*preLink=*/true);
   std::error_code err;
   llvm::raw_fd_ostream stream(filename, err, llvm::sys::fs::OF_None);
-  llvm::WriteBitcodeToFile(*M, stream);
+  if (lto == THIN_LTO) {
+    auto index = llvm::buildModuleSummaryIndex(*M, /*GetBFICallback=*/nullptr,
+                                               /*PSI=*/nullptr);
+    llvm::WriteBitcodeToFile(*M, stream, /*ShouldPreserveUseListOrder=*/false, &index);
+  } else {
+    llvm::WriteBitcodeToFile(*M, stream);
+  }
   if (err) {
     compilationError(err.message());
   }
@@ -393,7 +400,7 @@ void LLVMVisitor::writeToBitcodeFile(const std::string &filename) {
 
 void LLVMVisitor::writeToLLFile(const std::string &filename, bool optimize) {
   if (optimize)
-    runLLVMPipeline();
+    runLLVMPipeline(/*preLink=*/true);
   auto fo = fopen(filename.c_str(), "w");
   llvm::raw_fd_ostream fout(fileno(fo), true);
   fout << *M;
@@ -471,8 +478,15 @@ void LLVMVisitor::writeToExecutable(const std::string &filename,
   if (library)
     setupGlobalCtorForSharedLibrary();
 
-  const std::string objFile = filename + ".o";
-  writeToObjectFile(objFile, /*pic=*/library);
+  const bool useLTO = (lto != NO_LTO);
+  const std::string objFile = filename + (useLTO ? ".bc" : ".o");
+  if (useLTO) {
+    if (library)
+      M->setPICLevel(llvm::PICLevel::BigPIC);
+    writeToBitcodeFile(objFile);
+  } else {
+    writeToObjectFile(objFile, /*pic=*/library);
+  }
 
   const std::string base = ast::executable_path(argv0.c_str());
   auto path = llvm::SmallString<128>(llvm::sys::path::parent_path(base));
@@ -492,12 +506,42 @@ void LLVMVisitor::writeToExecutable(const std::string &filename,
     rpaths.push_back(std::string(path));
   }
 
-  std::vector<std::string> command = {"g++"};
+  llvm::SmallVector<llvm::StringRef> userFlags(16);
+  llvm::StringRef(lflags).split(userFlags, " ", /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+
+  // A linker picked via -fuse-ld in the user's flags takes precedence
+  const bool userLinker = llvm::any_of(
+      userFlags, [](llvm::StringRef flag) { return flag.startswith("-fuse-ld="); });
+
+  // LTO requires a bitcode-aware linker driver
+  const std::string driver = useLTO ? "clang++" : "g++";
+  if (useLTO) {
+    if (!llvm::sys::findProgramByName(driver))
+      compilationError("LTO requires '" + driver + "', which was not found in PATH");
+#ifndef __APPLE__
+    if (!userLinker && !llvm::sys::findProgramByName("ld.lld"))
+      compilationError("LTO requires 'ld.lld', which was not found in PATH; install "
+                       "lld or select a bitcode-aware linker with "
+                       "-linker-flags=-fuse-ld=<linker>");
+#endif
+  }
+
+  std::vector<std::string> command = {driver};
   // Avoid "argument unused during compilation" warning
   command.push_back("-Wno-unused-command-line-argument");
   // MUST go before -llib to compile on Linux
   command.push_back(objFile);
 
+  if (useLTO) {
+    command.push_back(lto == THIN_LTO ? "-flto=thin" : "-flto");
+#ifndef __APPLE__
+    if (!userLinker)
+      command.push_back("-fuse-ld=lld");
+#endif
+    if (!db.debug)
+      command.push_back("-O3");
+  }
+
   if (library)
     command.push_back("-shared");
 
@@ -554,9 +598,6 @@ void LLVMVisitor::writeToExecutable(const std::string &filename,
     command.push_back(arg);
   }
 
-  llvm::SmallVector<llvm::StringRef> userFlags(16);
-  llvm::StringRef(lflags).split(userFlags, " ", /*MaxSplit=*/-1, /*KeepEmpty=*/false);
-
   for (const auto &uflag : userFlags) {
     if (!uflag.empty())
       command.push_back(uflag.str());
@@ -4,6 +4,7 @@
 
 #include "codon/cir/cir.h"
 #include "codon/cir/llvm/llvm.h"
+#include "codon/cir/llvm/optimize.h"
 #include "codon/cir/pyextension.h"
 #include "codon/dsl/plugins.h"
 #include "codon/util/common.h"
@@ -153,6 +154,10 @@ private:
   DebugInfo db;
   /// Plugin manager
   PluginManager *plugins;
+  /// Link-time optimization mode
+  LTOMode lto;
+  /// Whether to report loop vectorization results
+  bool vectorizeReport;
 
   llvm::DIType *
   getDITypeHelper(types::Type *t,
@@ -206,8 +211,8 @@ private:
   // Python extension setup
   llvm::Function *createPyTryCatchWrapper(llvm::Function *func);
 
-  // LLVM passes
-  void runLLVMPipeline();
+  // LLVM passes; pre-link pipeline is used if LTO is enabled and preLink is set
+  void runLLVMPipeline(bool preLink = false);
 
   llvm::Value *getVar(const Var *var);
   void insertVar(const Var *var, llvm::Value *x) { vars.emplace(var->getId(), x); }
@@ -279,6 +284,21 @@ public:
   /// @param f flags
   void setFlags(const std::string &f) { db.flags = f; }
 
+  /// @return link-time optimization mode
+  LTOMode getLTO() const { return lto; }
+  /// Sets link-time optimization mode. If enabled, bitcode rather than
+  /// native object code is handed to the linker when writing executables.
+  /// @param l the LTO mode
+  void setLTO(LTOMode l) { lto = l; }
+
+  /// @return true if reporting loop vectorization results
+  bool getVectorizeReport() const { return vectorizeReport; }
+  /// Sets whether to report loop vectorization results. If set,
+  /// LLVM's loop vectorizer remarks are printed along with their
+  /// source locations when the module is optimized.
+  /// @param v true to report vectorization results
+  void setVectorizeReport(bool v = true) { vectorizeReport = v; }
+
   llvm::LLVMContext &getContext() { return *context; }
   llvm::IRBuilder<> &getBuilder() { return *B; }
   llvm::Module *getModule() { return M.get(); }
@@ -334,7 +354,8 @@ public:
   /// @param filename the .o file to write to
   /// @param pic true to write position-independent code
   void writeToObjectFile(const std::string &filename, bool pic = false);
-  /// Writes module as LLVM bitcode file.
+  /// Writes module as LLVM bitcode file. Includes a module
+  /// summary index if ThinLTO is enabled.
   /// @param filename the .bc file to write to
   void writeToBitcodeFile(const std::string &filename);
   /// Writes module as LLVM IR file.
@@ -342,6 +363,9 @@ public:
   void writeToLLFile(const std::string &filename, bool optimize = true);
   /// Writes module as native executable. Invokes an
   /// external linker to generate the final executable.
+  /// If LTO is enabled, the module is passed to the linker
+  /// as bitcode so it can be optimized together with other
+  /// bitcode inputs given via the linker flags.
   /// @param filename the file to write to
   /// @param argv0 compiler's argv[0] used to set rpath
   /// @param library whether to make a shared library
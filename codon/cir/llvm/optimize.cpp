@@ -4,6 +4,8 @@
 
 #include <algorithm>
 #include <deque>
+#include <set>
+#include <tuple>
 
 #include "codon/cir/llvm/gpu.h"
 #include "codon/util/common.h"
@@ -72,11 +74,65 @@ void applyDebugTransformations(llvm::Module *module, bool debug, bool jit) {
         }
       }
     }
+  } else if (module->getContext().getDiagHandlerPtr()->isAnyRemarkEnabled()) {
+    // keep line tables so that remarks can refer to source locations
+    llvm::stripNonLineTableDebugInfo(*module);
   } else {
     llvm::StripDebugInfo(*module);
   }
 }
 
+/// Collects remarks from LLVM's loop vectorizer. Remarks are
+/// de-duplicated since the optimization pipeline runs twice.
+struct VectorizationRemarkCollector : public llvm::DiagnosticHandler {
+  static const std::string PASS_NAME;
+
+  /// (file, line, col, message) tuples, ordered by location
+  std::set<std::tuple<std::string, unsigned, unsigned, std::string>> remarks;
+
+  bool isAnalysisRemarkEnabled(llvm::StringRef passName) const override {
+    return passName == PASS_NAME;
+  }
+
+  bool isMissedOptRemarkEnabled(llvm::StringRef passName) const override {
+    return passName == PASS_NAME;
+  }
+
+  bool isPassedOptRemarkEnabled(llvm::StringRef passName) const override {
+    return passName == PASS_NAME;
+  }
+
+  // checked before stripping debug info, so line tables are kept for remarks
+  bool isAnyRemarkEnabled() const override { return true; }
+
+  bool handleDiagnostics(const llvm::DiagnosticInfo &di) override {
+    auto *remark = llvm::dyn_cast<llvm::DiagnosticInfoOptimizationBase>(&di);
+    if (!remark || remark->getPassName() != PASS_NAME)
+      return false;
+
+    std::string file;
+    unsigned line = 0, col = 0;
+    if (remark->isLocationAvailable()) {
+      auto loc = remark->getLocation();
+      file = loc.getAbsolutePath();
+      line = loc.getLine();
+      col = loc.getColumn();
+    }
+    remarks.emplace(file, line, col, remark->getMsg());
+    return true;
+  }
+
+  void report() const {
+    for (auto &r : remarks) {
+      auto &file = std::get<0>(r);
+      compilationRemark(std::get<3>(r), file, file.empty() ? 0 : std::get<1>(r),
+                        file.empty() ? 0 : std::get<2>(r));
+    }
+  }
+};
+
+const std::string VectorizationRemarkCollector::PASS_NAME = "loop-vectorize";
+
 struct AllocInfo {
   std::vector<std::string> allocators;
   std::string realloc;
@@ -827,7 +883,7 @@ struct CoroBranchSimplifier : public llvm::PassInfoMixin<CoroBranchSimplifier> {
 };
 
 void runLLVMOptimizationPasses(llvm::Module *module, bool debug, bool jit,
-                               PluginManager *plugins) {
+                               PluginManager *plugins, LTOMode lto = NO_LTO) {
   applyDebugTransformations(module, debug, jit);
 
   llvm::LoopAnalysisManager lam;
@@ -873,6 +929,15 @@ void runLLVMOptimizationPasses(llvm::Module *module, bool debug, bool jit,
     llvm::ModulePassManager mpm =
         pb.buildO0DefaultPipeline(llvm::OptimizationLevel::O0);
     mpm.run(*module, mam);
+  } else if (lto == THIN_LTO) {
+    // leave inlining across module boundaries to the linker
+    llvm::ModulePassManager mpm =
+        pb.buildThinLTOPreLinkDefaultPipeline(llvm::OptimizationLevel::O3);
+    mpm.run(*module, mam);
+  } else if (lto == FULL_LTO) {
+    llvm::ModulePassManager mpm =
+        pb.buildLTOPreLinkDefaultPipeline(llvm::OptimizationLevel::O3);
+    mpm.run(*module, mam);
   } else {
     llvm::ModulePassManager mpm =
         pb.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O3);
@@ -889,7 +954,18 @@ void verify(llvm::Module *module) {
 
 } // namespace
 
-void optimize(llvm::Module *module, bool debug, bool jit, PluginManager *plugins) {
+void optimize(llvm::Module *module, bool debug, bool jit, PluginManager *plugins,
+              LTOMode lto, bool vectorizeReport) {
+  auto &context = module->getContext();
+  VectorizationRemarkCollector *collector = nullptr;
+  std::unique_ptr<llvm::DiagnosticHandler> oldHandler;
+  if (vectorizeReport) {
+    auto handler = std::make_unique<VectorizationRemarkCollector>();
+    collector = handler.get();
+    oldHandler = context.getDiagnosticHandler();
+    context.setDiagnosticHandler(std::move(handler));
+  }
+
   verify(module);
   {
     TIME("llvm/opt1");
@@ -897,13 +973,18 @@ void optimize(llvm::Module *module, bool debug, bool jit, PluginManager *plugins
   }
   if (!debug) {
     TIME("llvm/opt2");
-    runLLVMOptimizationPasses(module, debug, jit, plugins);
+    runLLVMOptimizationPasses(module, debug, jit, plugins, lto);
   }
   {
     TIME("llvm/gpu");
     applyGPUTransformations(module);
   }
   verify(module);
+
+  if (collector) {
+    collector->report();
+    context.setDiagnosticHandler(std::move(oldHandler));
+  }
 }
 
 } // namespace ir
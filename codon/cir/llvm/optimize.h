@@ -9,6 +9,16 @@
 
 namespace codon {
 namespace ir {
+/// Link-time optimization modes used when emitting native code.
+enum LTOMode {
+  /// no link-time optimization; emit native object files
+  NO_LTO,
+  /// ThinLTO; emit bitcode with a module summary index
+  THIN_LTO,
+  /// monolithic LTO; emit plain bitcode
+  FULL_LTO,
+};
+
 std::unique_ptr<llvm::TargetMachine>
 getTargetMachine(llvm::Triple triple, llvm::StringRef cpuStr,
                  llvm::StringRef featuresStr, const llvm::TargetOptions &options,
@@ -19,6 +29,7 @@ getTargetMachine(llvm::Module *module, bool setFunctionAttributes = false,
                  bool pic = false);
 
 void optimize(llvm::Module *module, bool debug, bool jit = false,
-              PluginManager *plugins = nullptr);
+              PluginManager *plugins = nullptr, LTOMode lto = NO_LTO,
+              bool vectorizeReport = false);
 } // namespace ir
 } // namespace codon
@@ -0,0 +1,194 @@
+// Copyright (C) 2022-2024 Exaloop Inc. <https://exaloop.io>
+
+#include "alloc_demote.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "codon/cir/analyze/dataflow/capture.h"
+#include "codon/cir/util/irtools.h"
+#include "codon/cir/util/operator.h"
+#include "codon/util/common.h"
+
+namespace codon {
+namespace ir {
+namespace transform {
+namespace cleanup {
+namespace {
+const std::string GC_MODULE = "std.internal.gc";
+
+// Returns the type allocated by "T.__new__()" if T is a reference
+// type that can be placed on the stack.
+types::RefType *getAllocatedType(Value *v) {
+  auto *call = cast<CallInstr>(v);
+  if (!call || call->numArgs() != 0)
+    return nullptr;
+
+  auto *func = util::getFunc(call->getCallee());
+  auto *type = cast<types::RefType>(call->getType());
+  // only the compiler-generated allocator, not a user-defined __new__
+  if (!func || !type || func->getUnmangledName() != Module::NEW_MAGIC_NAME ||
+      !util::hasAttribute(func, "autogenerated"))
+    return nullptr;
+
+  // polymorphic types need RTTI; finalizers would never run
+  auto *M = v->getModule();
+  if (type->isPolymorphic() || M->getOrRealizeMethod(type, "__del__", {type}))
+    return nullptr;
+
+  return type;
+}
+
+// Returns the variable holding the given value, looking through
+// "(stmts; v)" flow instructions.
+Var *getHolder(Value *v) {
+  while (auto *flow = cast<FlowInstr>(v))
+    v = flow->getValue();
+  auto *var = cast<VarValue>(v);
+  return var ? var->getVar() : nullptr;
+}
+
+// Tracks how each variable of a function is used. A use is "safe" if it
+// cannot make the variable's value reachable from anywhere but the
+// variable itself: reading or writing a field, or passing it to a
+// function that does not capture the corresponding argument.
+struct UseTracker : public util::Operator {
+  analyze::dataflow::CaptureResult *cr;
+  std::vector<AssignInstr *> sites;
+  std::unordered_map<id_t, int> assigns;
+  std::unordered_map<id_t, int> uses;
+  std::unordered_map<id_t, int> safeUses;
+  std::unordered_set<id_t> addressTaken;
+  // "x = (...; v)" copies, mapping v to all such x
+  std::unordered_map<id_t, std::vector<Var *>> copies;
+  bool hasTry;
+
+  explicit UseTracker(analyze::dataflow::CaptureResult *cr)
+      : util::Operator(), cr(cr), sites(), assigns(), uses(), safeUses(),
+        addressTaken(), copies(), hasTry(false) {}
+
+  void safe(Value *v) {
+    if (auto *var = getHolder(v))
+      ++safeUses[var->getId()];
+  }
+
+  bool ok(Var *var) const {
+    auto id = var->getId();
+    auto count = [&](const std::unordered_map<id_t, int> &m) {
+      auto it = m.find(id);
+      return it != m.end() ? it->second : 0;
+    };
+    return count(assigns) == 1 && count(uses) == count(safeUses) &&
+           !addressTaken.count(id);
+  }
+
+  void handle(TryCatchFlow *v) override { hasTry = true; }
+  void handle(VarValue *v) override { ++uses[v->getVar()->getId()]; }
+  void handle(PointerValue *v) override { addressTaken.insert(v->getVar()->getId()); }
+  void handle(ExtractInstr *v) override { safe(v->getVal()); }
+  void handle(InsertInstr *v) override { safe(v->getLhs()); }
+
+  void handle(AssignInstr *v) override {
+    auto *lhs = v->getLhs();
+    ++assigns[lhs->getId()];
+    if (getAllocatedType(v->getRhs())) {
+      sites.push_back(v);
+    } else if (isA<FlowInstr>(v->getRhs())) {
+      if (auto *var = getHolder(v->getRhs())) {
+        copies[var->getId()].push_back(lhs);
+        ++safeUses[var->getId()];
+      }
+    }
+  }
+
+  void handle(CallInstr *v) override {
+    auto *func = util::getFunc(v->getCallee());
+    if (!func)
+      return;
+    auto it = cr->results.find(func->getId());
+    if (it == cr->results.end())
+      return;
+
+    unsigned i = 0;
+    for (auto *arg : *v) {
+      if (i < it->second.size() && !it->second[i])
+        safe(arg);
+      ++i;
+    }
+  }
+};
+} // namespace
+
+const std::string AllocationDemotionPass::KEY = "core-cleanup-alloc-demote";
+
+void AllocationDemotionPass::run(Module *m) {
+  numDemotions = 0;
+  auto *cr = getAnalysisResult<analyze::dataflow::CaptureResult>(captureKey);
+  if (!cr)
+    return;
+
+  std::vector<BodiedFunc *> funcs = {cast<BodiedFunc>(m->getMainFunc())};
+  for (auto *var : *m) {
+    if (auto *func = cast<BodiedFunc>(var))
+      funcs.push_back(func);
+  }
+
+  for (auto *func : funcs) {
+    if (!func || !func->getBody())
+      continue;
+
+    UseTracker tracker(cr);
+    func->accept(tracker);
+    // an exception thrown by __init__ could leave an older object from
+    // the same site visible after the slot is reused
+    if (tracker.hasTry)
+      continue;
+
+    for (auto *site : tracker.sites) {
+      auto *alloc = site->getRhs();
+      auto *type = getAllocatedType(alloc);
+
+      // the object may only live in the variable it is assigned to, and
+      // in variables assigned directly from that one, so that reusing
+      // one stack slot per allocation site is unobservable
+      bool ok = true;
+      std::vector<Var *> holders = {site->getLhs()};
+      std::unordered_set<id_t> seen;
+      while (ok && !holders.empty()) {
+        auto *var = holders.back();
+        holders.pop_back();
+        if (!seen.insert(var->getId()).second)
+          continue;
+        ok = !var->isGlobal() && tracker.ok(var);
+        auto it = tracker.copies.find(var->getId());
+        if (it != tracker.copies.end())
+          holders.insert(holders.end(), it->second.begin(), it->second.end());
+      }
+      if (!ok || analyze::dataflow::escapes(func, alloc, cr))
+        continue;
+
+      auto *M = func->getModule();
+      auto *stack = M->Nr<StackAllocInstr>(M->getArrayType(type->getContents()), 1);
+      auto *ptr = M->Nr<ExtractInstr>(stack, "ptr");
+      auto *newRefAt = M->getOrRealizeFunc("new_ref_at", {ptr->getType()}, {type},
+                                           GC_MODULE);
+      if (!newRefAt)
+        continue;
+
+      auto src = alloc->getSrcInfo();
+      alloc->replaceAll(util::call(newRefAt, {ptr}));
+      ++numDemotions;
+      LOG_IR("[{}] demoted allocation of {} in {}", KEY, type->getName(),
+             func->getName());
+      if (remarks)
+        compilationRemark(
+            fmt::format("allocation of '{}' moved to the stack", type->getName()),
+            src.file, src.line, src.col);
+    }
+  }
+}
+
+} // namespace cleanup
+} // namespace transform
+} // namespace ir
+} // namespace codon
@@ -0,0 +1,46 @@
+// Copyright (C) 2022-2024 Exaloop Inc. <https://exaloop.io>
+
+#pragma once
+
+#include "codon/cir/transform/pass.h"
+
+namespace codon {
+namespace ir {
+namespace transform {
+namespace cleanup {
+
+/// Demotes allocations of reference (class) types that provably do not
+/// escape their function from the GC heap to the stack.
+class AllocationDemotionPass : public Pass {
+private:
+  /// key of the capture analysis
+  std::string captureKey;
+  /// whether to emit a remark for each demoted allocation
+  bool remarks;
+  /// number of allocations we've demoted
+  int numDemotions;
+
+public:
+  static const std::string KEY;
+
+  /// Constructs an allocation demotion pass.
+  /// @param captureKey the capture analysis' key
+  /// @param remarks whether to emit a remark for each demoted allocation
+  explicit AllocationDemotionPass(const std::string &captureKey, bool remarks = false)
+      : Pass(), captureKey(captureKey), remarks(remarks), numDemotions(0) {}
+
+  std::string getKey() const override { return KEY; }
+  void run(Module *m) override;
+
+  /// Sets whether to emit a remark for each demoted allocation.
+  /// @param r true to emit remarks
+  void setRemarks(bool r) { remarks = r; }
+
+  /// @return number of allocations we've demoted
+  int getNumDemotions() const { return numDemotions; }
+};
+
+} // namespace cleanup
+} // namespace transform
+} // namespace ir
+} // namespace codon
@@ -0,0 +1,190 @@
+// Copyright (C) 2022-2024 Exaloop Inc. <https://exaloop.io>
+
+#include "specialize.h"
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "codon/cir/util/cloning.h"
+#include "codon/cir/util/irtools.h"
+#include "codon/cir/util/operator.h"
+
+namespace codon {
+namespace ir {
+namespace transform {
+namespace folding {
+namespace {
+const std::string EXPORT_ATTR = "std.internal.attributes.export";
+const std::string GPU_KERNEL_ATTR = "std.gpu.kernel";
+// set on functions that were specialized, and on their clones
+const std::string SPECIALIZED_ATTR = ".specialized";
+
+bool okConst(const Value *v) { return isA<IntConst>(v) || isA<BoolConst>(v); }
+
+int64_t constValue(const Value *v) {
+  if (auto *c = cast<IntConst>(v))
+    return c->getVal();
+  return cast<BoolConst>(v)->getVal() ? 1 : 0;
+}
+
+struct UsedVarCollector : public util::Operator {
+  std::unordered_set<id_t> &vars;
+  explicit UsedVarCollector(std::unordered_set<id_t> &vars) : vars(vars) {}
+  void handle(VarValue *v) override { vars.insert(v->getVar()->getId()); }
+};
+
+// Gathers the information needed to decide whether a function is worth
+// specializing: its size, whether it calls itself, and which variables
+// determine its control flow.
+struct FunctionInfo : public util::Operator {
+  Func *func;
+  int64_t size;
+  bool recursive;
+  std::unordered_set<id_t> controlVars;
+
+  explicit FunctionInfo(Func *func)
+      : util::Operator(), func(func), size(0), recursive(false), controlVars() {}
+
+  void addControl(Value *v) {
+    UsedVarCollector uvc(controlVars);
+    v->accept(uvc);
+  }
+
+  void preHook(Node *node) override { ++size; }
+
+  void handle(VarValue *v) override {
+    if (v->getVar()->getId() == func->getId())
+      recursive = true;
+  }
+
+  void handle(IfFlow *v) override { addControl(v->getCond()); }
+  void handle(WhileFlow *v) override { addControl(v->getCond()); }
+  void handle(ForFlow *v) override { addControl(v->getIter()); }
+  void handle(TernaryInstr *v) override { addControl(v->getCond()); }
+
+  void handle(ImperativeForFlow *v) override {
+    addControl(v->getStart());
+    addControl(v->getEnd());
+  }
+};
+
+struct CallSiteCollector : public util::Operator {
+  std::unordered_map<id_t, std::vector<CallInstr *>> calls;
+
+  void handle(CallInstr *v) override {
+    auto *func = cast<BodiedFunc>(util::getFunc(v->getCallee()));
+    if (func && std::any_of(v->begin(), v->end(), okConst))
+      calls[func->getId()].push_back(v);
+  }
+};
+
+bool canSpecialize(BodiedFunc *func) {
+  return func->getBody() && !func->isJIT() && !util::hasAttribute(func, EXPORT_ATTR) &&
+         !util::hasAttribute(func, GPU_KERNEL_ATTR) &&
+         !util::hasAttribute(func, SPECIALIZED_ATTR);
+}
+
+void markSpecialized(Func *func) {
+  std::map<std::string, std::string> attrs;
+  if (auto *attr = func->getAttribute<KeyValueAttribute>())
+    attrs = attr->attributes;
+  attrs[SPECIALIZED_ATTR] = "1";
+  func->setAttribute(std::make_unique<KeyValueAttribute>(std::move(attrs)));
+}
+
+// (argument index, constant value) pairs
+using ConstArgs = std::vector<std::pair<int, int64_t>>;
+} // namespace
+
+const std::string FunctionSpecializationPass::KEY =
+    "core-folding-func-specialization";
+
+void FunctionSpecializationPass::run(Module *m) {
+  numSpecializations = 0;
+
+  CallSiteCollector collector;
+  m->accept(collector);
+
+  for (auto &entry : collector.calls) {
+    auto *func = cast<BodiedFunc>(m->getVar(entry.first));
+    if (!func || !canSpecialize(func))
+      continue;
+
+    FunctionInfo info(func);
+    func->accept(info);
+    if (info.recursive || info.size > sizeBudget || info.controlVars.empty())
+      continue;
+
+    std::vector<Var *> args(func->arg_begin(), func->arg_end());
+    std::map<ConstArgs, std::vector<CallInstr *>> sites;
+    for (auto *call : entry.second) {
+      ConstArgs key;
+      int i = 0;
+      for (auto *arg : *call) {
+        if (okConst(arg) && info.controlVars.count(args[i]->getId()))
+          key.emplace_back(i, constValue(arg));
+        ++i;
+      }
+      if (!key.empty())
+        sites[key].push_back(call);
+    }
+
+    // only constants seen at several call sites are worth a clone
+    for (auto it = sites.begin(); it != sites.end();) {
+      if (it->second.size() < static_cast<std::size_t>(minCallSites))
+        it = sites.erase(it);
+      else
+        ++it;
+    }
+    if (sites.empty())
+      continue;
+
+    // specialize for the most common constant arguments first
+    std::vector<std::pair<ConstArgs, std::vector<CallInstr *>>> ranked(sites.begin(),
+                                                                        sites.end());
+    std::stable_sort(ranked.begin(), ranked.end(), [](const auto &a, const auto &b) {
+      return a.second.size() > b.second.size();
+    });
+    if (ranked.size() > static_cast<std::size_t>(maxClones))
+      ranked.resize(maxClones);
+
+    for (auto &site : ranked) {
+      util::CloneVisitor cv(m);
+      auto *clone = cv.forceClone(func);
+      clone->setParentType(func->getParentType());
+      std::vector<Var *> cloneArgs(clone->arg_begin(), clone->arg_end());
+
+      // convert:
+      //   def f(a, b):
+      //     body
+      // into (for b == c):
+      //   def f(a, b):
+      //     b = c
+      //     body
+      auto *call = site.second.front();
+      auto *body = m->N<SeriesFlow>(func->getSrcInfo());
+      for (auto &arg : site.first) {
+        auto *value = *std::next(call->begin(), arg.first);
+        body->push_back(m->Nr<AssignInstr>(cloneArgs[arg.first], cv.clone(value)));
+      }
+      body->push_back(clone->getBody());
+      clone->setBody(body);
+      markSpecialized(clone);
+
+      for (auto *c : site.second)
+        c->setCallee(m->Nr<VarValue>(clone));
+
+      ++numSpecializations;
+      LOG_IR("[{}] specialized {} for {} call site(s)", KEY, func->getName(),
+             site.second.size());
+    }
+    markSpecialized(func);
+  }
+}
+
+} // namespace folding
+} // namespace transform
+} // namespace ir
+} // namespace codon
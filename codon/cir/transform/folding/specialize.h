@@ -0,0 +1,51 @@
+// Copyright (C) 2022-2024 Exaloop Inc. <https://exaloop.io>
+
+#pragma once
+
+#include "codon/cir/transform/pass.h"
+
+namespace codon {
+namespace ir {
+namespace transform {
+namespace folding {
+
+/// Pass to specialize functions on constant arguments. Functions that
+/// branch or loop on a parameter and are called with a constant for it
+/// are cloned with that parameter fixed, and matching call sites are
+/// redirected to the clone. The folding passes then simplify the clone.
+/// Each function is specialized at most once, and clones never are, so
+/// running the pass again does not grow the module.
+class FunctionSpecializationPass : public Pass {
+private:
+  /// maximum size (in IR nodes) of functions to specialize
+  int sizeBudget;
+  /// maximum number of specializations of any one function
+  int maxClones;
+  /// minimum number of call sites sharing the same constants
+  int minCallSites;
+  /// number of specializations we've made
+  int numSpecializations;
+
+public:
+  static const std::string KEY;
+
+  /// Constructs a function specialization pass.
+  /// @param sizeBudget maximum size (in IR nodes) of functions to specialize
+  /// @param maxClones maximum number of specializations of any one function
+  /// @param minCallSites minimum number of call sites sharing the same constants
+  explicit FunctionSpecializationPass(int sizeBudget = 1000, int maxClones = 4,
+                                      int minCallSites = 2)
+      : Pass(), sizeBudget(sizeBudget), maxClones(maxClones),
+        minCallSites(minCallSites), numSpecializations(0) {}
+
+  std::string getKey() const override { return KEY; }
+  void run(Module *m) override;
+
+  /// @return number of specializations we've made
+  int getNumSpecializations() const { return numSpecializations; }
+};
+
+} // namespace folding
+} // namespace transform
+} // namespace ir
+} // namespace codon
@@ -11,16 +11,20 @@
 #include "codon/cir/analyze/dataflow/reaching.h"
 #include "codon/cir/analyze/module/global_vars.h"
 #include "codon/cir/analyze/module/side_effect.h"
+#include "codon/cir/transform/cleanup/alloc_demote.h"
 #include "codon/cir/transform/folding/folding.h"
+#include "codon/cir/transform/folding/specialize.h"
 #include "codon/cir/transform/lowering/imperative.h"
 #include "codon/cir/transform/lowering/pipeline.h"
 #include "codon/cir/transform/manager.h"
 #include "codon/cir/transform/parallel/openmp.h"
 #include "codon/cir/transform/pass.h"
+#include "codon/cir/transform/pythonic/bounds.h"
 #include "codon/cir/transform/pythonic/dict.h"
 #include "codon/cir/transform/pythonic/generator.h"
 #include "codon/cir/transform/pythonic/io.h"
 #include "codon/cir/transform/pythonic/list.h"
+#include "codon/cir/transform/pythonic/re.h"
 #include "codon/cir/transform/pythonic/str.h"
 #include "codon/util/common.h"
 
@@ -159,12 +163,20 @@ void PassManager::registerStandardPasses(PassManager::Init init) {
   }
   case Init::RELEASE:
   case Init::JIT: {
+    auto globalKey =
+        registerAnalysis(std::make_unique<analyze::module::GlobalVarsAnalyses>());
+
     // Pythonic
     registerPass(std::make_unique<pythonic::DictArithmeticOptimization>());
     registerPass(std::make_unique<pythonic::ListAdditionOptimization>());
+    registerPass(std::make_unique<pythonic::StrLoopAppendOptimization>());
     registerPass(std::make_unique<pythonic::StrAdditionOptimization>());
+    registerPass(std::make_unique<pythonic::StrFormatOptimization>());
+    registerPass(std::make_unique<pythonic::StrSplitFieldOptimization>());
     registerPass(std::make_unique<pythonic::GeneratorArgumentOptimization>());
     registerPass(std::make_unique<pythonic::IOCatOptimization>());
+    registerPass(std::make_unique<pythonic::RegexCompileHoisting>(globalKey),
+                 /*insertBefore=*/"", {globalKey}, {globalKey});
 
     // lowering
     registerPass(std::make_unique<lowering::PipelineLowering>());
@@ -179,8 +191,6 @@ void PassManager::registerStandardPasses(PassManager::Init init) {
     auto capKey = registerAnalysis(
         std::make_unique<analyze::dataflow::CaptureAnalysis>(rdKey, domKey),
         {rdKey, domKey});
-    auto globalKey =
-        registerAnalysis(std::make_unique<analyze::module::GlobalVarsAnalyses>());
     auto seKey1 =
         registerAnalysis(std::make_unique<analyze::module::SideEffectAnalysis>(
                              capKey,
@@ -191,12 +201,29 @@ void PassManager::registerStandardPasses(PassManager::Init init) {
                              capKey,
                              /*globalAssignmentHasSideEffects=*/false),
                          {capKey});
+
+    // function specialization; clones are simplified by folding below. Not in
+    // JIT mode, where the passes rerun over functions that were already compiled.
+    if (init != Init::JIT)
+      registerPass(std::make_unique<folding::FunctionSpecializationPass>(),
+                   /*insertBefore=*/"", {}, {cfgKey, globalKey});
+
+    // bounds checks
+    registerPass(std::make_unique<pythonic::BoundsCheckElimination>(rdKey, seKey1),
+                 /*insertBefore=*/"", {rdKey, seKey1}, {cfgKey});
+    registerPass(std::make_unique<pythonic::ListBoundsCheckVersioning>(seKey1),
+                 /*insertBefore=*/"", {seKey1}, {cfgKey});
+
     registerPass(std::make_unique<folding::FoldingPassGroup>(
                      seKey1, rdKey, globalKey, /*repeat=*/5, /*runGlobalDemoton=*/false,
                      pyNumerics),
                  /*insertBefore=*/"", {seKey1, rdKey, globalKey},
                  {seKey1, rdKey, cfgKey, globalKey, capKey});
 
+    // allocation demotion
+    registerPass(std::make_unique<cleanup::AllocationDemotionPass>(capKey),
+                 /*insertBefore=*/"", {capKey}, {cfgKey, globalKey});
+
     // parallel
     registerPass(std::make_unique<parallel::OpenMPPass>(), /*insertBefore=*/"", {},
                  {cfgKey, globalKey});
@@ -163,6 +163,14 @@ public:
   /// @param module the module
   void run(Module *module);
 
+  /// Gets a registered pass.
+  /// @param key the (unique'd) pass key
+  /// @return the pass, or null if no such pass is registered
+  Pass *getPass(const std::string &key) {
+    auto it = passes.find(key);
+    return it != passes.end() ? it->second.pass.get() : nullptr;
+  }
+
   /// Gets the result of a given analysis.
   /// @param key the (unique'd) analysis key
   /// @return the result
@@ -104,12 +104,20 @@ struct Reduction {
     XOR,
     MIN,
     MAX,
+    CUSTOM,
   };
 
   Kind kind = Kind::NONE;
   Var *shared = nullptr;
+  /// for CUSTOM, the method merging a private accumulator into another
+  Func *merge = nullptr;
+  /// true if "shared" holds the accumulator itself rather than a pointer
+  /// to it, as for containers that are mutated but never reassigned
+  bool byValue = false;
 
   types::Type *getType() {
+    if (byValue)
+      return shared->getType();
     auto *ptrType = cast<types::PointerType>(shared->getType());
     seqassertn(ptrType, "expected shared var to be of pointer type");
     return ptrType->getBase();
@@ -185,6 +193,15 @@ struct Reduction {
 
   Value *generateNonAtomicReduction(Value *ptr, Value *arg) {
     auto *M = ptr->getModule();
+    if (kind == Kind::CUSTOM) {
+      // "ptr" is the accumulator itself when reducing into a by-value shared
+      bool isPtr = !ptr->getType()->is(getType());
+      auto *merged = util::call(merge, {isPtr ? util::ptrLoad(ptr) : ptr, arg});
+      if (isPtr && merged->getType()->is(getType()))
+        return util::ptrStore(ptr, merged);
+      return merged;
+    }
+
     Value *lhs = util::ptrLoad(ptr);
     Value *result = nullptr;
     switch (kind) {
@@ -364,13 +381,104 @@ struct ReductionIdentifier : public util::Operator {
   std::vector<Var *> shareds;
   Var *loopVarArg;
   std::unordered_map<id_t, Reduction> reductions;
+  /// unmodified args that are only ever accumulated into, e.g. via
+  /// "lst.append(x)" or "counts.update(xs)"; each thread gets a private
+  /// accumulator that is merged into the original at the end
+  std::vector<Var *> captureds;
+  std::unordered_map<id_t, Reduction> containerReductions;
+  std::unordered_set<id_t> receivers;
+  std::unordered_set<id_t> disqualified;
 
   ReductionIdentifier()
-      : util::Operator(), shareds(), loopVarArg(nullptr), reductions() {}
+      : util::Operator(), shareds(), loopVarArg(nullptr), reductions(), captureds(),
+        containerReductions(), receivers(), disqualified() {}
 
-  ReductionIdentifier(std::vector<Var *> shareds, Var *loopVarArg)
+  ReductionIdentifier(std::vector<Var *> shareds, Var *loopVarArg,
+                      std::vector<Var *> captureds = {})
       : util::Operator(), shareds(std::move(shareds)), loopVarArg(loopVarArg),
-        reductions() {}
+        reductions(), captureds(std::move(captureds)), containerReductions(),
+        receivers(), disqualified() {}
+
+  bool isCaptured(Var *var) {
+    if (loopVarArg && var->getId() == loopVarArg->getId())
+      return false;
+    return std::any_of(captureds.begin(), captureds.end(),
+                       [&](Var *v) { return v->getId() == var->getId(); });
+  }
+
+  /// @return whether the type is a stdlib List, Set, Dict or Counter, whose
+  /// accumulating methods are known
+  static bool isStdlibContainer(types::Type *type) {
+    static const std::vector<std::string> prefixes = {
+        "std.internal.types.ptr.List[",
+        "std.internal.types.collections.set.Set[",
+        "std.internal.types.collections.dict.Dict[",
+        "std.collections.Counter[",
+    };
+    auto name = type->getName();
+    return std::any_of(prefixes.begin(), prefixes.end(), [&](const std::string &p) {
+      return name.rfind(p, 0) == 0;
+    });
+  }
+
+  /// @return the merge method for an accumulating method, or empty if none
+  static std::string getMergeMethod(const std::string &name, bool stdlib) {
+    static const std::unordered_map<std::string, std::string> stdlibMerges = {
+        {"append", "extend"},
+        {"extend", "extend"},
+        {"add", "update"},
+        {"update", "update"},
+    };
+    if (name == Module::IADD_MAGIC_NAME || name == Module::IOR_MAGIC_NAME)
+      return name;
+    if (!stdlib)
+      return "";
+    auto it = stdlibMerges.find(name);
+    return it != stdlibMerges.end() ? it->second : "";
+  }
+
+  /// Identifies "acc.method(...)" on a captured var, as a statement whose
+  /// result is unused. Types that define "combine(self, other)" may use any
+  /// of their methods this way, and are merged with "combine"; otherwise
+  /// only "__iadd__"/"__ior__" and the accumulating methods of the stdlib
+  /// containers are allowed.
+  Reduction getContainerReductionFromCall(CallInstr *v) {
+    auto *M = v->getModule();
+    auto *func = util::getFunc(v->getCallee());
+    if (!func || v->numArgs() == 0 || !getParent<SeriesFlow>())
+      return {};
+    auto *self = cast<VarValue>(v->front());
+    if (!self || !isCaptured(self->getVar()))
+      return {};
+    auto *type = self->getVar()->getType();
+    if (!func->getParentType() || !func->getParentType()->is(type))
+      return {};
+
+    std::string mergeName = "combine";
+    auto *merge = M->getOrRealizeMethod(type, mergeName, {type, type});
+    if (!merge) {
+      mergeName = getMergeMethod(func->getUnmangledName(), isStdlibContainer(type));
+      if (mergeName.empty())
+        return {};
+      merge = M->getOrRealizeMethod(type, mergeName, {type, type});
+      if (!merge)
+        return {};
+    }
+
+    Reduction reduction = {Reduction::Kind::CUSTOM, self->getVar(), merge,
+                           /*byValue=*/true};
+    if (!reduction.getInitial())
+      return {};
+    receivers.insert(self->getId());
+    return reduction;
+  }
+
+  Reduction getContainerReduction(Var *var) {
+    if (disqualified.count(var->getId()))
+      return {};
+    auto it = containerReductions.find(var->getId());
+    return (it != containerReductions.end()) ? it->second : Reduction();
+  }
 
   bool isShared(Var *shared) {
     if (loopVarArg && shared->getId() == loopVarArg->getId())
@@ -438,6 +546,24 @@ struct ReductionIdentifier : public util::Operator {
                         M->getNoneType(), /*method=*/true))
       return {};
 
+    // "acc += x" or "acc |= x" on other types, e.g. containers or user
+    // classes with an associative __iadd__/__ior__, merged the same way
+    if (!isA<types::IntType>(type) && !isA<types::FloatType>(type) &&
+        !isA<types::Float32Type>(type)) {
+      for (auto &name : {Module::IADD_MAGIC_NAME, Module::IOR_MAGIC_NAME}) {
+        if (!util::isCallOf(item, name, {type, type}, type, /*method=*/true))
+          continue;
+        auto *call = cast<CallInstr>(item);
+        if (!isSharedDeref(shared, call->front()))
+          return {};
+        Reduction reduction = {Reduction::Kind::CUSTOM, shared,
+                               util::getFunc(call->getCallee())};
+        if (!reduction.getInitial())
+          return {};
+        return reduction;
+      }
+    }
+
     const std::vector<ReductionFunction> reductionFunctions = {
         {Module::ADD_MAGIC_NAME, Reduction::Kind::ADD, true},
         {Module::MUL_MAGIC_NAME, Reduction::Kind::MUL, true},
@@ -513,10 +639,31 @@ struct ReductionIdentifier : public util::Operator {
       // otherwise mark as invalid via an empty reduction
       if (it == reductions.end()) {
         reductions.emplace(reduction.shared->getId(), reduction);
-      } else if (it->second && it->second.kind != reduction.kind) {
+      } else if (it->second && (it->second.kind != reduction.kind ||
+                                it->second.merge != reduction.merge)) {
         it->second = {};
       }
     }
+
+    if (auto reduction = getContainerReductionFromCall(v)) {
+      auto it = containerReductions.find(reduction.shared->getId());
+      if (it == containerReductions.end()) {
+        containerReductions.emplace(reduction.shared->getId(), reduction);
+      } else if (it->second.merge != reduction.merge) {
+        disqualified.insert(reduction.shared->getId());
+      }
+    }
+  }
+
+  // any other use of a captured accumulator rules out privatizing it
+  void handle(VarValue *v) override {
+    if (!receivers.count(v->getId()) && isCaptured(v->getVar()))
+      disqualified.insert(v->getVar()->getId());
+  }
+
+  void handle(PointerValue *v) override {
+    if (isCaptured(v->getVar()))
+      disqualified.insert(v->getVar()->getId());
   }
 };
 
@@ -684,12 +831,34 @@ struct ParallelLoopTemplateReplacer : public LoopTemplateReplacer {
 struct ImperativeLoopTemplateReplacer : public ParallelLoopTemplateReplacer {
   OMPSched *sched;
   int64_t step;
+  std::vector<int64_t> breakCodes;
 
   ImperativeLoopTemplateReplacer(BodiedFunc *parent, CallInstr *replacement,
                                  Var *loopVar, ReductionIdentifier *reds,
-                                 OMPSched *sched, int64_t step)
+                                 OMPSched *sched, int64_t step,
+                                 std::vector<int64_t> breakCodes)
       : ParallelLoopTemplateReplacer(parent, replacement, loopVar, reds), sched(sched),
-        step(step) {}
+        step(step), breakCodes(std::move(breakCodes)) {}
+
+  // The body stub returns whether the iteration broke out of the loop.
+  Value *bodyStubResult(CallInstr *bodyCall) {
+    auto *M = bodyCall->getModule();
+    auto *series = M->Nr<SeriesFlow>();
+    if (breakCodes.empty()) {
+      series->push_back(bodyCall);
+      return M->Nr<FlowInstr>(series, M->getBool(false));
+    }
+
+    auto *codeVar = M->Nr<Var>(M->getIntType());
+    parent->push_back(codeVar);
+    series->push_back(M->Nr<AssignInstr>(codeVar, bodyCall));
+    Value *broke = nullptr;
+    for (auto code : breakCodes) {
+      auto *check = *M->Nr<VarValue>(codeVar) == *M->getInt(code);
+      broke = broke ? *broke || *check : check;
+    }
+    return M->Nr<FlowInstr>(series, broke);
+  }
 
   void handle(CallInstr *v) override {
     ParallelLoopTemplateReplacer::handle(v);
@@ -729,8 +898,9 @@ struct ImperativeLoopTemplateReplacer : public ParallelLoopTemplateReplacer {
             types::Type *base = cast<types::PointerType>(arg->getType())->getBase();
 
             // get extras again since we'll be inserting the new var before extras local
-            Var *lastArg = parent->arg_back(); // ptr to {chunk, start, stop, extras}
-            Value *val = util::tupleGet(util::ptrLoad(M->Nr<VarValue>(lastArg)), 3);
+            // ptr to {chunk, start, stop, cancel, extras}
+            Var *lastArg = parent->arg_back();
+            Value *val = util::tupleGet(util::ptrLoad(M->Nr<VarValue>(lastArg)), 4);
             Value *initVal = util::ptrLoad(util::tupleGet(val, next));
 
             Reduction reduction = reds->getReduction(*outlinedArgs);
@@ -746,6 +916,16 @@ struct ImperativeLoopTemplateReplacer : public ParallelLoopTemplateReplacer {
 
             newArg = M->Nr<PointerValue>(newVar->getVar());
             ++next;
+          } else if (auto reduction = reds->getContainerReduction(*outlinedArgs)) {
+            // private accumulator, merged into the original in _loop_reductions
+            auto *initVal = reduction.getInitial();
+            seqassertn(initVal && initVal->getType()->is(arg->getType()),
+                       "unknown reduction init value");
+            VarValue *newVar = util::makeVar(
+                initVal, cast<SeriesFlow>(parent->getBody()), parent, /*prepend=*/true);
+            sharedInfo.push_back({next, newVar->getVar(), reduction});
+            newArg = M->Nr<VarValue>(newVar->getVar());
+            ++next;
           } else {
             newArg = util::tupleGet(M->Nr<VarValue>(extras), next++);
           }
@@ -764,7 +944,7 @@ struct ImperativeLoopTemplateReplacer : public ParallelLoopTemplateReplacer {
         ++outlinedArgs;
       }
 
-      v->replaceAll(util::call(outlinedFunc, newArgs));
+      v->replaceAll(bodyStubResult(util::call(outlinedFunc, newArgs)));
       replacement = nullptr;
     }
 
@@ -796,6 +976,28 @@ struct ImperativeLoopTemplateReplacer : public ParallelLoopTemplateReplacer {
     if (name == "_loop_ordered") {
       v->replaceAll(M->getBool(sched->ordered));
     }
+
+    if (name == "_loop_site") {
+      v->replaceAll(M->Nr<VarValue>(createLoopSite(M)));
+    }
+  }
+
+  /// Creates the global holding the tuning state of an adaptive loop,
+  /// which outlives individual executions of the loop.
+  Var *createLoopSite(Module *M) {
+    auto *siteType = M->getOrRealizeType("_LoopSite", {}, ompModule);
+    seqassertn(siteType, "openmp._LoopSite type not found");
+    auto *var = M->Nr<Var>(siteType, /*global=*/true);
+    static int counter = 1;
+    var->setName(".omp_loop_site." + std::to_string(counter++));
+
+    // add it to main function so it doesn't get demoted by IR pass
+    auto *series = cast<SeriesFlow>(cast<BodiedFunc>(M->getMainFunc())->getBody());
+    auto *init = (*siteType)();
+    seqassertn(init, "could not initialize openmp._LoopSite");
+    series->insert(series->begin(), M->Nr<AssignInstr>(var, init));
+
+    return var;
   }
 };
 
@@ -1225,32 +1427,60 @@ struct OpenMPTransformData {
   util::OutlineResult outline;
   std::vector<Var *> sharedVars;
   ReductionIdentifier reds;
+  std::vector<int64_t> breakCodes; // outlined func return codes that stop the loop
 };
 
 template <typename T> OpenMPTransformData unpar(T *v) {
   v->setParallel(false);
-  return {{}, {}, {}};
+  return {{}, {}, {}, {}};
+}
+
+// Returns the loop targeted by a break or continue; null means the
+// innermost enclosing loop.
+Value *getFlowTarget(Value *v) {
+  if (auto *br = cast<BreakInstr>(v))
+    return br->getLoop();
+  if (auto *cont = cast<ContinueInstr>(v))
+    return cont->getLoop();
+  return nullptr;
 }
 
 template <typename T>
-OpenMPTransformData setupOpenMPTransform(T *v, BodiedFunc *parent, bool gpu) {
+OpenMPTransformData setupOpenMPTransform(T *v, BodiedFunc *parent, bool gpu,
+                                         bool cancellable = false) {
   if (!v->isParallel())
     return unpar(v);
   auto *M = v->getModule();
   auto *body = cast<SeriesFlow>(v->getBody());
   if (!parent || !body)
     return unpar(v);
-  auto outline = util::outlineRegion(parent, body, /*allowOutflows=*/false,
+  auto outline = util::outlineRegion(parent, body, /*allowOutflows=*/cancellable,
                                      /*outlineGlobals=*/true, /*allByValue=*/gpu);
   if (!outline)
     return unpar(v);
 
+  // A break of the parallel loop stops it and a continue just ends the
+  // iteration. Returns and jumps out of enclosing loops can't be taken from
+  // another thread, so such loops stay serial; the call site of the outlined
+  // body already performs them.
+  std::vector<int64_t> breakCodes;
+  for (unsigned i = 0; i < outline.outFlows.size(); i++) {
+    auto *flow = outline.outFlows[i];
+    auto *target = getFlowTarget(flow);
+    if (!(isA<BreakInstr>(flow) || isA<ContinueInstr>(flow)) ||
+        (target && target->getId() != v->getId()))
+      return unpar(v);
+    if (isA<BreakInstr>(flow))
+      breakCodes.push_back(i + 1);
+  }
+
   // set up args to pass fork_call
   Var *loopVar = v->getVar();
   std::vector<Value *> outlineCallArgs(outline.call->begin(), outline.call->end());
 
   // shared argument vars
   std::vector<Var *> sharedVars;
+  std::vector<Var *> capturedVars;
   Var *loopVarArg = nullptr;
   unsigned i = 0;
   for (auto it = outline.func->arg_begin(); it != outline.func->arg_end(); ++it) {
@@ -1260,17 +1490,20 @@ OpenMPTransformData setupOpenMPTransform(T *v, BodiedFunc *parent, bool gpu) {
       loopVarArg = *it;
     if (outline.argKinds[i] == util::OutlineResult::ArgKind::MODIFIED)
       sharedVars.push_back(*it);
+    else if (!gpu)
+      capturedVars.push_back(*it);
     ++i;
   }
-  ReductionIdentifier reds(sharedVars, loopVarArg);
+  ReductionIdentifier reds(sharedVars, loopVarArg, capturedVars);
   outline.func->accept(reds);
 
-  return {outline, sharedVars, reds};
+  return {outline, sharedVars, reds, breakCodes};
 }
 
 struct ForkCallData {
   CallInstr *fork = nullptr;
   CallInstr *pushNumThreads = nullptr;
+  CallInstr *pushProcBind = nullptr;
 };
 
 ForkCallData createForkCall(Module *M, OMPTypes &types, Value *rawTemplateFunc,
@@ -1289,6 +1522,13 @@ ForkCallData createForkCall(Module *M, OMPTypes &types, Value *rawTemplateFunc,
     seqassertn(pushNumThreadsFunc, "push num threads func not found");
     result.pushNumThreads = util::call(pushNumThreadsFunc, {sched->threads});
   }
+
+  if (sched->procBind >= 0) {
+    auto *pushProcBindFunc =
+        M->getOrRealizeFunc("_push_proc_bind", {types.i64}, {}, ompModule);
+    seqassertn(pushProcBindFunc, "push proc bind func not found");
+    result.pushProcBind = util::call(pushProcBindFunc, {M->getInt(sched->procBind)});
+  }
   return result;
 }
 
@@ -1399,6 +1639,29 @@ CollapseResult collapseLoop(BodiedFunc *parent, ImperativeForFlow *v, int64_t le
 
 const std::string OpenMPPass::KEY = "core-parallel-openmp";
 
+void OpenMPPass::setPlaces(const std::string &requested, Value *v) {
+  if (requested.empty())
+    return;
+
+  // places are fixed when the OpenMP runtime starts, so one value holds for
+  // the whole program
+  if (!places.empty()) {
+    if (places != requested)
+      warn("ignoring places '" + requested + "' as '" + places +
+               "' was given for another loop",
+           v);
+    return;
+  }
+  places = requested;
+
+  auto *M = v->getModule();
+  auto *setPlacesFunc = M->getOrRealizeFunc("_set_default_places",
+                                            {M->getStringType()}, {}, ompModule);
+  seqassertn(setPlacesFunc, "set default places func not found");
+  auto *series = cast<SeriesFlow>(cast<BodiedFunc>(M->getMainFunc())->getBody());
+  series->insert(series->begin(), util::call(setPlacesFunc, {M->getString(places)}));
+}
+
 void OpenMPPass::handle(ForFlow *v) {
   auto data = setupOpenMPTransform(v, cast<BodiedFunc>(getParentFunc()), /*gpu=*/false);
   if (!v->isParallel())
@@ -1497,6 +1760,9 @@ void OpenMPPass::handle(ForFlow *v) {
   auto forkData = createForkCall(M, types, rawTemplateFunc, forkExtraArgs, sched);
   if (forkData.pushNumThreads)
     insertBefore(forkData.pushNumThreads);
+  if (forkData.pushProcBind)
+    insertBefore(forkData.pushProcBind);
+  setPlaces(sched->places, v);
   v->replaceAll(forkData.fork);
 }
 
@@ -1516,8 +1782,8 @@ void OpenMPPass::handle(ImperativeForFlow *v) {
     }
   }
 
-  auto data =
-      setupOpenMPTransform(v, parent, (v->isParallel() && v->getSchedule()->gpu));
+  const bool gpu = v->isParallel() && v->getSchedule()->gpu;
+  auto data = setupOpenMPTransform(v, parent, gpu, /*cancellable=*/!gpu);
   if (!v->isParallel())
     return;
 
@@ -1547,6 +1813,10 @@ void OpenMPPass::handle(ImperativeForFlow *v) {
   std::string templateFuncName;
   if (sched->gpu) {
     templateFuncName = "_gpu_loop_outline_template";
+  } else if (sched->steal) {
+    templateFuncName = "_steal_loop_outline_template";
+  } else if (sched->adaptive) {
+    templateFuncName = "_adaptive_loop_outline_template";
   } else if (sched->dynamic) {
     templateFuncName = "_dynamic_loop_outline_template";
   } else if (sched->chunk) {
@@ -1598,10 +1868,18 @@ void OpenMPPass::handle(ImperativeForFlow *v) {
     v->replaceAll(util::call(
         templateFunc, {v->getStart(), v->getEnd(), util::makeTuple(extraArgs, M)}));
   } else {
+    // shared by the team to stop the loop early on a break or an exception
+    auto *cancelType = M->getOrRealizeType("_LoopCancel", {}, ompModule);
+    seqassertn(cancelType, "openmp._LoopCancel type not found");
+    auto *cancel = M->Nr<Var>(cancelType, /*global=*/false);
+    parent->push_back(cancel);
+    auto *cancelInit = (*cancelType)();
+    seqassertn(cancelInit, "could not initialize openmp._LoopCancel");
+
     std::vector<types::Type *> templateFuncArgs = {
         types.i32ptr, types.i32ptr,
-        M->getPointerType(M->getTupleType(
-            {types.i64, types.i64, types.i64, M->getTupleType(extraArgTypes)}))};
+        M->getPointerType(M->getTupleType({types.i64, types.i64, types.i64, cancelType,
+                                           M->getTupleType(extraArgTypes)}))};
     auto *templateFunc =
         M->getOrRealizeFunc(templateFuncName, templateFuncArgs, {}, ompModule);
     seqassertn(templateFunc, "imperative loop outline template not found");
@@ -1609,22 +1887,36 @@ void OpenMPPass::handle(ImperativeForFlow *v) {
     util::CloneVisitor cv(M);
     templateFunc = cast<Func>(cv.forceClone(templateFunc));
     ImperativeLoopTemplateReplacer rep(cast<BodiedFunc>(templateFunc), outline.call,
-                                       loopVar, &reds, sched, v->getStep());
+                                       loopVar, &reds, sched, v->getStep(),
+                                       data.breakCodes);
     templateFunc->accept(rep);
     auto *rawTemplateFunc = ptrFromFunc(templateFunc);
 
+    // a chunk of 0 lets the work stealing and adaptive templates pick their own
     auto *chunk = (sched->chunk && sched->chunk->getType()->is(types.i64))
                       ? sched->chunk
-                      : M->getInt(1);
-    std::vector<Value *> forkExtraArgs = {chunk, v->getStart(), v->getEnd()};
+                      : M->getInt((sched->steal || sched->adaptive) ? 0 : 1);
+    std::vector<Value *> forkExtraArgs = {chunk, v->getStart(), v->getEnd(),
+                                          M->Nr<VarValue>(cancel)};
     for (auto *arg : extraArgs) {
       forkExtraArgs.push_back(arg);
     }
 
+    // an exception raised in the loop body is rethrown here once the team
+    // has joined
+    auto *rethrowFunc =
+        M->getOrRealizeFunc("_loop_rethrow", {cancelType}, {}, ompModule);
+    seqassertn(rethrowFunc, "loop rethrow function not found");
+
     // fork call
     auto forkData = createForkCall(M, types, rawTemplateFunc, forkExtraArgs, sched);
     if (forkData.pushNumThreads)
       insertBefore(forkData.pushNumThreads);
+    if (forkData.pushProcBind)
+      insertBefore(forkData.pushProcBind);
+    setPlaces(sched->places, v);
+    insertBefore(M->Nr<AssignInstr>(cancel, cancelInit));
+    insertAfter(util::call(rethrowFunc, {M->Nr<VarValue>(cancel)}));
     v->replaceAll(forkData.fork);
   }
 }
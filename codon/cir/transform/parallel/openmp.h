@@ -19,6 +19,16 @@ public:
 
   void handle(ForFlow *) override;
   void handle(ImperativeForFlow *) override;
+
+private:
+  /// OMP_PLACES value requested by the first loop that gave one
+  std::string places;
+
+  /// Makes the program start by setting OMP_PLACES (unless already set in the
+  /// environment) to the places requested by the given loop.
+  /// @param requested the places requested, or empty if none
+  /// @param v the loop
+  void setPlaces(const std::string &requested, Value *v);
 };
 
 } // namespace parallel
@@ -30,7 +30,8 @@ int getScheduleCode(const std::string &schedule = "static", bool chunked = false
       else
         return 34;
     }
-  } else if (schedule == "dynamic") {
+  } else if (schedule == "dynamic" || schedule == "steal" ||
+             schedule == "adaptive") {
     return (ordered ? 67 : 35) | modifier;
   } else if (schedule == "guided") {
     return (ordered ? 68 : 36) | modifier;
@@ -42,6 +43,22 @@ int getScheduleCode(const std::string &schedule = "static", bool chunked = false
   return getScheduleCode(); // default
 }
 
+int getProcBindCode(const std::string &procBind) {
+  // codes from "enum kmp_proc_bind_t" at
+  // https://github.com/llvm/llvm-project/blob/main/openmp/runtime/src/kmp.h
+  if (procBind == "false")
+    return 0;
+  else if (procBind == "true")
+    return 1;
+  else if (procBind == "primary" || procBind == "master")
+    return 2;
+  else if (procBind == "close")
+    return 3;
+  else if (procBind == "spread")
+    return 4;
+  return -1; // unspecified
+}
+
 Value *nullIfNeg(Value *v) {
   if (v && util::isConst<int64_t>(v) && util::getConst<int64_t>(v) <= 0)
     return nullptr;
@@ -50,18 +67,23 @@ Value *nullIfNeg(Value *v) {
 } // namespace
 
 OMPSched::OMPSched(int code, bool dynamic, Value *threads, Value *chunk, bool ordered,
-                   int64_t collapse, bool gpu)
+                   int64_t collapse, bool gpu, bool steal, bool adaptive,
+                   int procBind, std::string places)
     : code(code), dynamic(dynamic), threads(nullIfNeg(threads)),
-      chunk(nullIfNeg(chunk)), ordered(ordered), collapse(collapse), gpu(gpu) {
+      chunk(nullIfNeg(chunk)), ordered(ordered), collapse(collapse), gpu(gpu),
+      steal(steal), adaptive(adaptive), procBind(procBind), places(std::move(places)) {
   if (code < 0)
     this->code = getScheduleCode();
 }
 
 OMPSched::OMPSched(const std::string &schedule, Value *threads, Value *chunk,
-                   bool ordered, int64_t collapse, bool gpu)
+                   bool ordered, int64_t collapse, bool gpu,
+                   const std::string &procBind, std::string places)
     : OMPSched(getScheduleCode(schedule, nullIfNeg(chunk) != nullptr, ordered),
                (schedule != "static") || ordered, threads, chunk, ordered, collapse,
-               gpu) {}
+               gpu, (schedule == "steal") && !ordered,
+               (schedule == "adaptive") && !ordered, getProcBindCode(procBind),
+               std::move(places)) {}
 
 std::vector<Value *> OMPSched::getUsedValues() const {
   std::vector<Value *> ret;
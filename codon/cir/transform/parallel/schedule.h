@@ -20,16 +20,27 @@ struct OMPSched {
   bool ordered;
   int64_t collapse;
   bool gpu;
+  /// whether iterations are distributed by work stealing (schedule="steal")
+  bool steal;
+  /// whether the schedule is tuned at runtime per loop site (schedule="adaptive")
+  bool adaptive;
+  /// thread affinity policy as a kmp_proc_bind_t value, or -1 if unspecified
+  int procBind;
+  /// OMP_PLACES value to use for the program, or empty if unspecified
+  std::string places;
 
   explicit OMPSched(int code = -1, bool dynamic = false, Value *threads = nullptr,
                     Value *chunk = nullptr, bool ordered = false, int64_t collapse = 0,
-                    bool gpu = false);
+                    bool gpu = false, bool steal = false, bool adaptive = false,
+                    int procBind = -1, std::string places = "");
   explicit OMPSched(const std::string &code, Value *threads = nullptr,
                     Value *chunk = nullptr, bool ordered = false, int64_t collapse = 0,
-                    bool gpu = false);
+                    bool gpu = false, const std::string &procBind = "",
+                    std::string places = "");
   OMPSched(const OMPSched &s)
       : code(s.code), dynamic(s.dynamic), threads(s.threads), chunk(s.chunk),
-        ordered(s.ordered), collapse(s.collapse), gpu(s.gpu) {}
+        ordered(s.ordered), collapse(s.collapse), gpu(s.gpu), steal(s.steal),
+        adaptive(s.adaptive), procBind(s.procBind), places(s.places) {}
 
   std::vector<Value *> getUsedValues() const;
   int replaceUsedValue(id_t id, Value *newValue);
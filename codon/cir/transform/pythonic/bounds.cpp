@@ -0,0 +1,436 @@
+// Copyright (C) 2022-2024 Exaloop Inc. <https://exaloop.io>
+
+#include "bounds.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "codon/cir/analyze/dataflow/reaching.h"
+#include "codon/cir/analyze/module/side_effect.h"
+#include "codon/cir/util/cloning.h"
+#include "codon/cir/util/irtools.h"
+
+namespace codon {
+namespace ir {
+namespace transform {
+namespace pythonic {
+namespace {
+
+static const std::string LIST = "std.internal.types.ptr.List";
+static const std::string BUILTIN = "std.internal.builtin";
+
+bool isList(const Value *v) {
+  return v->getType()->getName().rfind(LIST + "[", 0) == 0;
+}
+
+bool isInt(const Value *v) { return v->getType()->is(v->getModule()->getIntType()); }
+
+bool isStr(const Value *v) { return v->getType()->is(v->getModule()->getStringType()); }
+
+// Returns the list or string variable "seq" if the given value is
+// "len(seq)", "seq.__len__()" or "seq.len".
+Var *getLengthOf(Value *v) {
+  auto *M = v->getModule();
+  Value *seq = nullptr;
+  if (auto *extract = cast<ExtractInstr>(v)) {
+    if (extract->getField() == "len")
+      seq = extract->getVal();
+  } else if (auto *call = cast<CallInstr>(v)) {
+    auto *f = util::getFunc(call->getCallee());
+    if (f && call->numArgs() == 1) {
+      auto *arg = call->front();
+      if (f->getUnmangledName() == Module::LEN_MAGIC_NAME) {
+        seq = arg;
+      } else if (f->getUnmangledName() == "len") {
+        auto *len = M->getOrRealizeFunc("len", {arg->getType()}, {}, BUILTIN);
+        if (len && len->getId() == f->getId())
+          seq = arg;
+      }
+    }
+  }
+
+  auto *var = cast<VarValue>(seq);
+  return (var && (isList(var) || isStr(var))) ? var->getVar() : nullptr;
+}
+
+// Returns true if the given value is "i", "i + c", "c + i" or "i - c" for
+// the given (integer) index variable "i" and an integer constant "c".
+bool getIndexOffset(Value *v, Var *idxVar, int64_t &offset) {
+  auto isIdx = [&](Value *x) {
+    auto *var = cast<VarValue>(x);
+    return var && var->getVar()->getId() == idxVar->getId();
+  };
+
+  if (isIdx(v)) {
+    offset = 0;
+    return true;
+  }
+
+  auto *M = v->getModule();
+  auto *intType = M->getIntType();
+  bool add = util::isCallOf(v, Module::ADD_MAGIC_NAME, {intType, intType}, intType,
+                            /*method=*/true);
+  bool sub = util::isCallOf(v, Module::SUB_MAGIC_NAME, {intType, intType}, intType,
+                            /*method=*/true);
+  if (!add && !sub)
+    return false;
+
+  auto *call = cast<CallInstr>(v);
+  auto *lhs = call->front();
+  auto *rhs = call->back();
+  if (add && isA<IntConst>(lhs))
+    std::swap(lhs, rhs);
+
+  auto *c = cast<IntConst>(rhs);
+  if (!c || !isIdx(lhs))
+    return false;
+
+  offset = add ? c->getVal() : -c->getVal();
+  return true;
+}
+
+// Returns the list variable if the given call is "lst[i]" or "lst[i] = x"
+// for a list variable "lst" and the given (integer) index variable "i".
+Var *getCheckedAccess(CallInstr *v, Var *idxVar) {
+  auto *f = util::getFunc(v->getCallee());
+  if (!f)
+    return nullptr;
+
+  auto name = f->getUnmangledName();
+  if (!((name == Module::GETITEM_MAGIC_NAME && v->numArgs() == 2) ||
+        (name == Module::SETITEM_MAGIC_NAME && v->numArgs() == 3)))
+    return nullptr;
+
+  auto it = v->begin();
+  auto *list = cast<VarValue>(*it++);
+  auto *idx = cast<VarValue>(*it);
+  if (!list || !idx || !isList(list) || idx->getVar()->getId() != idxVar->getId())
+    return nullptr;
+
+  return list->getVar();
+}
+
+// List methods that never shrink the list they are called on.
+bool isNonShrinkingListCall(CallInstr *v, Func *f) {
+  if (v->numArgs() == 0 || !isList(v->front()))
+    return false;
+
+  auto name = f->getUnmangledName();
+  if (name == Module::SETITEM_MAGIC_NAME) // slice assignment can shrink
+    return v->numArgs() == 3 && isInt(*std::next(v->begin()));
+  return name == Module::GETITEM_MAGIC_NAME || name == Module::LEN_MAGIC_NAME ||
+         name == "_get" || name == "_set" || name == "append";
+}
+
+// Tracks whether a region of code might reassign a variable or shrink a list.
+struct MutationChecker : public util::Operator {
+  analyze::module::SideEffectResult *se;
+  std::unordered_set<id_t> modified;
+  bool valid;
+
+  explicit MutationChecker(analyze::module::SideEffectResult *se)
+      : util::Operator(), se(se), modified(), valid(true) {}
+
+  bool unmodified(const Var *var) const { return !modified.count(var->getId()); }
+
+  // consumer could modify the list while suspended
+  void handle(YieldInstr *v) override { valid = false; }
+  // e.g. "lst.len = 0"
+  void handle(InsertInstr *v) override { valid = false; }
+
+  void handle(AssignInstr *v) override { modified.insert(v->getLhs()->getId()); }
+  void handle(PointerValue *v) override { modified.insert(v->getVar()->getId()); }
+
+  void handle(CallInstr *v) override {
+    auto *f = util::getFunc(v->getCallee());
+    if (!f) {
+      valid = false;
+      return;
+    }
+
+    if (isNonShrinkingListCall(v, f))
+      return;
+
+    // anything that might modify some list is off-limits
+    auto it = se->result.find(f->getId());
+    if (it == se->result.end() || it->second > util::SideEffectStatus::NO_CAPTURE)
+      valid = false;
+  }
+};
+
+struct CheckedAccessFinder : public MutationChecker {
+  Var *loopVar;
+  std::vector<Var *> lists;
+
+  CheckedAccessFinder(Var *loopVar, analyze::module::SideEffectResult *se)
+      : MutationChecker(se), loopVar(loopVar), lists() {}
+
+  using MutationChecker::handle;
+
+  bool ok() const {
+    if (!valid || lists.empty() || !unmodified(loopVar))
+      return false;
+    return std::all_of(lists.begin(), lists.end(),
+                       [&](Var *list) { return unmodified(list); });
+  }
+
+  // only innermost loops are versioned
+  void handle(WhileFlow *v) override { valid = false; }
+  void handle(ForFlow *v) override { valid = false; }
+  void handle(ImperativeForFlow *v) override { valid = false; }
+
+  void handle(CallInstr *v) override {
+    if (auto *list = getCheckedAccess(v, loopVar)) {
+      if (std::find(lists.begin(), lists.end(), list) == lists.end())
+        lists.push_back(list);
+      return;
+    }
+    MutationChecker::handle(v);
+  }
+};
+
+// A checked "seq[i + c]" or "seq[i + c] = x" access of a list or string.
+struct IndexedAccess {
+  CallInstr *call;
+  Var *seq;
+  int64_t offset;
+};
+
+bool getIndexedAccess(CallInstr *v, Var *idxVar, IndexedAccess &access) {
+  auto *f = util::getFunc(v->getCallee());
+  if (!f)
+    return false;
+
+  auto name = f->getUnmangledName();
+  bool get = (name == Module::GETITEM_MAGIC_NAME && v->numArgs() == 2);
+  bool set = (name == Module::SETITEM_MAGIC_NAME && v->numArgs() == 3);
+  if (!get && !set)
+    return false;
+
+  auto it = v->begin();
+  auto *seq = cast<VarValue>(*it++);
+  if (!seq || !(isList(seq) || (get && isStr(seq))))
+    return false;
+
+  int64_t offset = 0;
+  if (!getIndexOffset(*it, idxVar, offset))
+    return false;
+
+  access = {v, seq->getVar(), offset};
+  return true;
+}
+
+struct IndexedAccessFinder : public MutationChecker {
+  Var *loopVar;
+  std::vector<IndexedAccess> accesses;
+
+  IndexedAccessFinder(Var *loopVar, analyze::module::SideEffectResult *se)
+      : MutationChecker(se), loopVar(loopVar), accesses() {}
+
+  using MutationChecker::handle;
+
+  void handle(CallInstr *v) override {
+    IndexedAccess access;
+    if (getIndexedAccess(v, loopVar, access)) {
+      accesses.push_back(access);
+      return;
+    }
+    MutationChecker::handle(v);
+  }
+};
+
+// Replaces a checked list or string access with the unchecked equivalent.
+void makeUnchecked(CallInstr *v, Var *seq) {
+  auto *M = v->getModule();
+  auto *type = seq->getType();
+  Func *unchecked = nullptr;
+  if (v->numArgs() == 2) {
+    unchecked = M->getOrRealizeMethod(type, "_get", {type, M->getIntType()});
+  } else {
+    auto *f = util::getFunc(v->getCallee());
+    auto *valType = (*std::next(f->arg_begin(), 2))->getType();
+    unchecked = M->getOrRealizeMethod(type, "_set", {type, M->getIntType(), valType});
+  }
+  seqassertn(unchecked, "could not find unchecked access [{}]", v->getSrcInfo());
+  v->setCallee(M->Nr<VarValue>(unchecked));
+}
+
+struct CheckedAccessReplacer : public util::Operator {
+  Var *loopVar;
+  const std::vector<Var *> &lists;
+
+  CheckedAccessReplacer(Var *loopVar, const std::vector<Var *> &lists)
+      : util::Operator(/*childrenFirst=*/true), loopVar(loopVar), lists(lists) {}
+
+  void handle(CallInstr *v) override {
+    auto *list = getCheckedAccess(v, loopVar);
+    if (list && std::find(lists.begin(), lists.end(), list) != lists.end())
+      makeUnchecked(v, list);
+  }
+};
+// Returns the single definition of the given variable reaching the given
+// location, or null if there is not exactly one.
+Value *getUniqueDefinition(analyze::dataflow::RDInspector *rd,
+                           analyze::dataflow::CFGraph *cfg, Var *var, Value *loc) {
+  auto reaching = rd->getReachingDefinitions(var, loc);
+  if (reaching.size() != 1 || *reaching.begin() == -1)
+    return nullptr;
+  return cfg->getValue(*reaching.begin());
+}
+} // namespace
+
+const std::string BoundsCheckElimination::KEY =
+    "core-pythonic-bounds-check-elimination";
+
+void BoundsCheckElimination::handle(SeriesFlow *v) {
+  auto *M = v->getModule();
+  auto *func = getParentFunc();
+  auto *r = getAnalysisResult<analyze::dataflow::RDResult>(reachingDefKey);
+  auto *se = getAnalysisResult<analyze::module::SideEffectResult>(sideEffectsKey);
+  if (!func || !r || !se)
+    return;
+
+  auto it = r->results.find(func->getId());
+  auto it2 = r->cfgResult->graphs.find(func->getId());
+  if (it == r->results.end() || it2 == r->cfgResult->graphs.end())
+    return;
+  auto *rd = it->second.get();
+  auto *cfg = it2->second.get();
+
+  auto *intType = M->getIntType();
+  std::vector<Value *> stmts(v->begin(), v->end());
+  for (std::size_t i = 0; i < stmts.size(); i++) {
+    auto *loop = cast<ImperativeForFlow>(stmts[i]);
+    if (!loop || loop->getStep() <= 0)
+      continue;
+
+    // start must be a known non-negative constant
+    auto *start = loop->getStart();
+    if (auto *var = cast<VarValue>(start))
+      start = getUniqueDefinition(rd, cfg, var->getVar(), var);
+    auto *startConst = cast<IntConst>(start);
+    if (!startConst || startConst->getVal() < 0)
+      continue;
+
+    // end must be "len(seq) - k" for some constant k >= 0
+    auto *end = loop->getEnd();
+    int64_t endOffset = 0;
+    if (util::isCallOf(end, Module::SUB_MAGIC_NAME, {intType, intType}, intType,
+                       /*method=*/true)) {
+      auto *call = cast<CallInstr>(end);
+      auto *k = cast<IntConst>(call->back());
+      if (!k || k->getVal() < 0)
+        continue;
+      endOffset = -k->getVal();
+      end = call->front();
+    }
+
+    Var *seq = getLengthOf(end);
+    if (!seq) {
+      // look for "n = len(seq)" earlier in this series, with nothing in
+      // between that could shrink or reassign "seq"
+      auto *var = cast<VarValue>(end);
+      auto *def = var ? getUniqueDefinition(rd, cfg, var->getVar(), var) : nullptr;
+      if (!def)
+        continue;
+
+      MutationChecker between(se);
+      for (auto j = i; j-- > 0;) {
+        auto *assign = cast<AssignInstr>(stmts[j]);
+        if (assign && assign->getLhs()->getId() == var->getVar()->getId() &&
+            assign->getRhs()->getId() == def->getId()) {
+          seq = getLengthOf(def);
+          break;
+        }
+        stmts[j]->accept(between);
+      }
+
+      if (!seq || !between.valid || !between.unmodified(seq))
+        continue;
+    }
+
+    IndexedAccessFinder finder(loop->getVar(), se);
+    loop->getBody()->accept(finder);
+    if (!finder.valid || !finder.unmodified(loop->getVar()) ||
+        !finder.unmodified(seq))
+      continue;
+
+    // with start <= i < len(seq) + endOffset, "seq[i + c]" is in bounds if
+    // start + c >= 0 and endOffset + c <= 0
+    for (auto &access : finder.accesses) {
+      if (access.seq->getId() == seq->getId() &&
+          startConst->getVal() + access.offset >= 0 && endOffset + access.offset <= 0)
+        makeUnchecked(access.call, seq);
+    }
+  }
+}
+
+const std::string ListBoundsCheckVersioning::KEY =
+    "core-pythonic-list-bounds-versioning";
+
+void ListBoundsCheckVersioning::handle(ImperativeForFlow *v) {
+  auto *M = v->getModule();
+  auto *parent = cast<BodiedFunc>(getParentFunc());
+  if (!parent || v->isParallel())
+    return;
+
+  auto *se = getAnalysisResult<analyze::module::SideEffectResult>(sideEffectsKey);
+  if (!se)
+    return;
+
+  CheckedAccessFinder finder(v->getVar(), se);
+  v->getBody()->accept(finder);
+  if (!finder.ok())
+    return;
+
+  // convert:
+  //   imp_for i in range(start, end, step):
+  //     ... lst[i] ...
+  // into:
+  //   s = start
+  //   e = end
+  //   if 0 <= s and e <= len(lst):  (for step > 0)
+  //     imp_for i in range(s, e, step):
+  //       ... lst._get(i) ...
+  //   else:
+  //     imp_for i in range(s, e, step):
+  //       ... lst[i] ...
+  util::CloneVisitor cv(M);
+  auto *series = M->N<SeriesFlow>(v->getSrcInfo());
+  auto *startVar = util::makeVar(cv.clone(v->getStart()), series, parent)->getVar();
+  auto *endVar = util::makeVar(cv.clone(v->getEnd()), series, parent)->getVar();
+
+  Value *cond = nullptr;
+  for (auto *list : finder.lists) {
+    auto *len = M->Nr<ExtractInstr>(M->Nr<VarValue>(list), "len");
+    Value *check = nullptr;
+    if (v->getStep() > 0) {
+      check = *(*M->Nr<VarValue>(startVar) >= *M->getInt(0)) &&
+              *(*M->Nr<VarValue>(endVar) <= *len);
+    } else {
+      check = *(*M->Nr<VarValue>(endVar) >= *M->getInt(-1)) &&
+              *(*M->Nr<VarValue>(startVar) < *len);
+    }
+    cond = cond ? (*cond && *check) : check;
+  }
+
+  // separate cloners since each caches its clones
+  auto *fast = cast<ImperativeForFlow>(util::CloneVisitor(M).clone(v));
+  auto *slow = cast<ImperativeForFlow>(util::CloneVisitor(M).clone(v));
+  for (auto *loop : {fast, slow}) {
+    loop->setStart(M->Nr<VarValue>(startVar));
+    loop->setEnd(M->Nr<VarValue>(endVar));
+  }
+
+  CheckedAccessReplacer replacer(fast->getVar(), finder.lists);
+  fast->getBody()->accept(replacer);
+
+  series->push_back(M->N<IfFlow>(v->getSrcInfo(), cond, util::series(fast),
+                                 util::series(slow)));
+  v->replaceAll(series);
+}
+
+} // namespace pythonic
+} // namespace transform
+} // namespace ir
+} // namespace codon
@@ -0,0 +1,65 @@
+// Copyright (C) 2022-2024 Exaloop Inc. <https://exaloop.io>
+
+#pragma once
+
+#include "codon/cir/transform/pass.h"
+
+namespace codon {
+namespace ir {
+namespace transform {
+namespace pythonic {
+
+/// Pass to remove bounds checks from list and string accesses that
+/// are provably in range. Handles "seq[i + c]" where "i" is the variable
+/// of a loop over "range(start, len(seq) - k)" for constants "start",
+/// "c" and "k", with "len(seq)" either given directly or through a
+/// variable whose reaching definition precedes the loop. Checked
+/// accesses are replaced with "_get"/"_set".
+class BoundsCheckElimination : public OperatorPass {
+private:
+  /// key of the reaching definition analysis
+  std::string reachingDefKey;
+  /// key of the side effect analysis
+  std::string sideEffectsKey;
+
+public:
+  static const std::string KEY;
+
+  /// Constructs a bounds check elimination pass.
+  /// @param reachingDefKey the reaching definition analysis' key
+  /// @param sideEffectsKey the side effect analysis' key
+  BoundsCheckElimination(const std::string &reachingDefKey,
+                         const std::string &sideEffectsKey)
+      : OperatorPass(), reachingDefKey(reachingDefKey),
+        sideEffectsKey(sideEffectsKey) {}
+
+  std::string getKey() const override { return KEY; }
+  void handle(SeriesFlow *v) override;
+};
+
+/// Pass to version innermost imperative for-loops that index lists
+/// with the loop variable. A single range check is placed before
+/// the loop; if it passes, a copy of the loop using unchecked list
+/// accesses is run instead of the original. Removing the checks and
+/// their exception edges lets LLVM vectorize the loop.
+class ListBoundsCheckVersioning : public OperatorPass {
+private:
+  /// key of the side effect analysis
+  std::string sideEffectsKey;
+
+public:
+  static const std::string KEY;
+
+  /// Constructs a list bounds check versioning pass.
+  /// @param sideEffectsKey the side effect analysis' key
+  explicit ListBoundsCheckVersioning(const std::string &sideEffectsKey)
+      : OperatorPass(/*childrenFirst=*/true), sideEffectsKey(sideEffectsKey) {}
+
+  std::string getKey() const override { return KEY; }
+  void handle(ImperativeForFlow *v) override;
+};
+
+} // namespace pythonic
+} // namespace transform
+} // namespace ir
+} // namespace codon
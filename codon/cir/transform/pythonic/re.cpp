@@ -0,0 +1,138 @@
+// Copyright (C) 2022-2024 Exaloop Inc. <https://exaloop.io>
+
+#include "re.h"
+
+#include <unordered_set>
+
+#include "codon/cir/analyze/module/global_vars.h"
+#include "codon/cir/util/cloning.h"
+#include "codon/cir/util/irtools.h"
+
+namespace codon {
+namespace ir {
+namespace transform {
+namespace pythonic {
+namespace {
+const std::string reModule = "std.re";
+
+bool isReFunc(Func *func) {
+  if (auto *attr = func->getAttribute<KeyValueAttribute>())
+    return attr->get(".module") == "std::re";
+  return false;
+}
+
+bool isHoistable(const std::string &name) {
+  static const std::unordered_set<std::string> names = {
+      "compile", "search", "match", "fullmatch", "finditer",
+      "findall", "split",  "sub",   "subn"};
+  return names.count(name);
+}
+
+Var *createSlot(Module *M) {
+  auto *slotType = M->getPointerType(M->getByteType());
+  auto *var = M->Nr<Var>(slotType, /*global=*/true);
+  static int counter = 1;
+  var->setName(".re_pattern." + std::to_string(counter++));
+
+  // add it to main function so it doesn't get demoted by IR pass
+  auto *series = cast<SeriesFlow>(cast<BodiedFunc>(M->getMainFunc())->getBody());
+  auto *init = (*slotType)();
+  seqassertn(init, "could not initialize regex slot");
+  series->insert(series->begin(), M->Nr<AssignInstr>(var, init));
+
+  return var;
+}
+} // namespace
+
+const std::string RegexCompileHoisting::KEY = "core-pythonic-regex-hoist";
+
+bool RegexCompileHoisting::getFlags(Value *v, int64_t &out, int depth) {
+  if (depth > 16)
+    return false;
+
+  if (auto *c = cast<IntConst>(v)) {
+    out = c->getVal();
+    return true;
+  }
+
+  // globals assigned exactly once, like the re module's flag constants
+  if (auto *vv = cast<VarValue>(v)) {
+    auto *var = vv->getVar();
+    auto *r = getAnalysisResult<analyze::module::GlobalVarsResult>(globalVarsKey);
+    if (!var->isGlobal() || !r)
+      return false;
+    auto it = r->assignments.find(var->getId());
+    if (it == r->assignments.end() || it->second == -1)
+      return false;
+    auto *def = v->getModule()->getValue(it->second);
+    return def && getFlags(def, out, depth + 1);
+  }
+
+  auto *call = cast<CallInstr>(v);
+  auto *func = call ? util::getFunc(call->getCallee()) : nullptr;
+  auto *M = v->getModule();
+  auto *i64 = M->getIntType();
+  if (!func || !util::isCallOf(call, func->getUnmangledName(), {i64, i64}, i64,
+                               /*method=*/true))
+    return false;
+
+  int64_t a, b;
+  if (!getFlags(call->front(), a, depth + 1) || !getFlags(call->back(), b, depth + 1))
+    return false;
+
+  auto name = func->getUnmangledName();
+  if (name == Module::OR_MAGIC_NAME)
+    out = a | b;
+  else if (name == Module::AND_MAGIC_NAME)
+    out = a & b;
+  else if (name == Module::XOR_MAGIC_NAME)
+    out = a ^ b;
+  else if (name == Module::ADD_MAGIC_NAME)
+    out = a + b;
+  else if (name == Module::LSHIFT_MAGIC_NAME && b >= 0 && b < 32)
+    out = a << b;
+  else
+    return false;
+  return true;
+}
+
+void RegexCompileHoisting::handle(CallInstr *v) {
+  auto *M = v->getModule();
+  auto *func = cast<BodiedFunc>(util::getFunc(v->getCallee()));
+  if (!func || !isReFunc(func) || !isHoistable(func->getUnmangledName()) ||
+      v->numArgs() < 2)
+    return;
+
+  // pattern is always first and flags always last
+  auto *pattern = cast<StringConst>(v->front());
+  int64_t flags = 0;
+  if (!pattern || !getFlags(v->back(), flags))
+    return;
+
+  std::vector<types::Type *> types = {
+      M->getPointerType(M->getPointerType(M->getByteType()))};
+  for (auto *arg : *v) {
+    types.push_back(arg->getType());
+  }
+  auto *replacementFunc = M->getOrRealizeFunc(
+      "_" + func->getUnmangledName() + "_static", types, {}, reModule);
+  if (!replacementFunc)
+    return;
+
+  auto key = std::to_string(flags) + ":" + pattern->getVal();
+  auto it = slots.find(key);
+  if (it == slots.end())
+    it = slots.emplace(key, createSlot(M)).first;
+
+  util::CloneVisitor cv(M);
+  std::vector<Value *> args = {M->Nr<PointerValue>(it->second)};
+  for (auto *arg : *v) {
+    args.push_back(cv.clone(arg));
+  }
+  v->replaceAll(util::call(replacementFunc, args));
+}
+
+} // namespace pythonic
+} // namespace transform
+} // namespace ir
+} // namespace codon
@@ -0,0 +1,45 @@
+// Copyright (C) 2022-2024 Exaloop Inc. <https://exaloop.io>
+
+#pragma once
+
+#include <unordered_map>
+
+#include "codon/cir/transform/pass.h"
+
+namespace codon {
+namespace ir {
+namespace transform {
+namespace pythonic {
+
+/// Pass to hoist compilation of string-literal regex patterns out of
+/// module-level "re" calls like re.match(r"...", s). Each distinct
+/// (pattern, flags) pair gets a global slot that holds a compiled regex
+/// shared by all threads; calls are redirected to "_<name>_static"
+/// variants that compile into the slot on first use. Flags may be
+/// literals, the module's flag constants (re.I etc.) or |, &, ^, + and <<
+/// of these.
+class RegexCompileHoisting : public OperatorPass {
+private:
+  /// key of the global variables analysis
+  std::string globalVarsKey;
+  /// global slots, keyed by pattern and flags
+  std::unordered_map<std::string, Var *> slots;
+
+  bool getFlags(Value *v, int64_t &out, int depth = 0);
+
+public:
+  static const std::string KEY;
+
+  /// Constructs a regex compile hoisting pass.
+  /// @param globalVarsKey the global variables analysis' key
+  explicit RegexCompileHoisting(const std::string &globalVarsKey)
+      : OperatorPass(), globalVarsKey(globalVarsKey) {}
+
+  std::string getKey() const override { return KEY; }
+  void handle(CallInstr *v) override;
+};
+
+} // namespace pythonic
+} // namespace transform
+} // namespace ir
+} // namespace codon
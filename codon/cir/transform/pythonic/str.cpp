@@ -3,6 +3,8 @@
 #include "str.h"
 
 #include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "codon/cir/util/cloning.h"
 #include "codon/cir/util/irtools.h"
@@ -39,6 +41,128 @@ void inspect(Value *v, InspectionResult &r) {
     r.valid = false;
   }
 }
+
+bool isValidFormat(const std::string &format, types::Type *type) {
+  auto *M = type->getModule();
+  try {
+    if (type->is(M->getIntType()))
+      (void)fmt::format(fmt::runtime(format), int64_t(0));
+    else if (type->is(M->getFloatType()))
+      (void)fmt::format(fmt::runtime(format), 0.0);
+    else
+      (void)fmt::format(fmt::runtime(format), fmt::string_view());
+  } catch (const std::runtime_error &) {
+    return false;
+  }
+  return true;
+}
+
+bool isFormattable(types::Type *type) {
+  auto *M = type->getModule();
+  return type->is(M->getIntType()) || type->is(M->getFloatType()) ||
+         type->is(M->getStringType());
+}
+
+/// Lowers a single f-string part to a (value, format) pair.
+/// @param v the part
+/// @param cv the clone visitor
+/// @return the pair, or null if the part should be copied as-is
+Value *lowerFormatPart(Value *v, util::CloneVisitor &cv) {
+  auto *M = v->getModule();
+  auto *call = cast<CallInstr>(v);
+  if (!call || call->numArgs() == 0 || !isFormattable(call->front()->getType()))
+    return nullptr;
+  auto *type = call->front()->getType();
+
+  std::string format;
+  if (util::isCallOf(v, "__format__", {type, M->getStringType()}, M->getStringType(),
+                     /*method=*/true)) {
+    auto *spec = cast<StringConst>(call->back());
+    if (!spec)
+      return nullptr;
+    format = "{:" + spec->getVal() + "}";
+    if (!isValidFormat(format, type))
+      return nullptr;
+  } else if (util::isCallOf(v, Module::NEW_MAGIC_NAME, {type}, M->getStringType())) {
+    // str(str) is a no-op; copy the string directly
+    if (isString(call->front()))
+      return nullptr;
+  } else {
+    return nullptr;
+  }
+
+  return util::makeTuple({cv.clone(call->front()), M->getString(format)}, M);
+}
+
+// Returns the leaves of "s + a + b + ..." if "v" is "s = s + a + b + ...".
+std::vector<Value *> getAppendChain(AssignInstr *v) {
+  InspectionResult r;
+  inspect(v->getRhs(), r);
+  if (!r.valid || r.args.size() < 2)
+    return {};
+  auto *first = cast<VarValue>(r.args.front());
+  if (!first || first->getVar()->getId() != v->getLhs()->getId())
+    return {};
+  return r.args;
+}
+
+// Finds str variables whose only uses in a loop are "s = s + ...".
+struct StrAppendFinder : public util::Operator {
+  std::unordered_map<id_t, Var *> candidates;
+  std::unordered_set<id_t> disqualified;
+  std::unordered_set<id_t> updateReads;
+
+  void handle(AssignInstr *v) override {
+    auto *var = v->getLhs();
+    auto chain = getAppendChain(v);
+    if (chain.empty() || var->isGlobal()) {
+      disqualified.insert(var->getId());
+      return;
+    }
+    candidates[var->getId()] = var;
+    updateReads.insert(chain.front()->getId());
+  }
+
+  void handle(VarValue *v) override {
+    if (!updateReads.count(v->getId()))
+      disqualified.insert(v->getVar()->getId());
+  }
+
+  void handle(PointerValue *v) override { disqualified.insert(v->getVar()->getId()); }
+};
+
+// Checks for exception handlers and escaping variables in a function.
+struct StrAppendFuncChecker : public util::Operator {
+  bool hasTry = false;
+  std::unordered_set<id_t> addressTaken;
+
+  void handle(TryCatchFlow *v) override { hasTry = true; }
+  void handle(PointerValue *v) override { addressTaken.insert(v->getVar()->getId()); }
+};
+
+// Turns "s = s + a + b" into "buf.append(a); buf.append(b)".
+struct StrAppendReplacer : public util::Operator {
+  Func *appendFunc;
+  std::unordered_map<id_t, Var *> buffers;
+
+  explicit StrAppendReplacer(Func *appendFunc)
+      : util::Operator(), appendFunc(appendFunc), buffers() {}
+
+  void handle(AssignInstr *v) override {
+    auto it = buffers.find(v->getLhs()->getId());
+    if (it == buffers.end())
+      return;
+    auto *M = v->getModule();
+    auto chain = getAppendChain(v);
+    util::CloneVisitor cv(M);
+    auto *series = M->N<SeriesFlow>(v->getSrcInfo());
+    for (auto jt = chain.begin() + 1; jt != chain.end(); ++jt) {
+      series->push_back(
+          util::call(appendFunc, {M->Nr<VarValue>(it->second), cv.clone(*jt)}));
+    }
+    v->replaceAll(series);
+  }
+};
 } // namespace
 
 const std::string StrAdditionOptimization::KEY = "core-pythonic-str-addition-opt";
@@ -70,6 +194,166 @@ void StrAdditionOptimization::handle(CallInstr *v) {
   }
 }
 
+const std::string StrFormatOptimization::KEY = "core-pythonic-str-format-opt";
+
+void StrFormatOptimization::handle(CallInstr *v) {
+  auto *M = v->getModule();
+
+  auto *catFunc = util::getFunc(v->getCallee());
+  if (!catFunc || catFunc->getUnmangledName() != "cat" || v->numArgs() != 1)
+    return;
+
+  auto *realCat =
+      M->getOrRealizeMethod(M->getStringType(), "cat", {v->front()->getType()});
+  if (!realCat || realCat->getId() != catFunc->getId())
+    return;
+
+  auto *parts = cast<CallInstr>(v->front());
+  auto *partsFunc = parts ? util::getFunc(parts->getCallee()) : nullptr;
+  if (!partsFunc || partsFunc->getUnmangledName() != Module::NEW_MAGIC_NAME)
+    return;
+
+  util::CloneVisitor cv(M);
+  std::vector<Value *> args;
+  bool lowered = false;
+  for (auto *part : *parts) {
+    if (!isString(part))
+      return;
+    if (auto *pair = lowerFormatPart(part, cv)) {
+      args.push_back(pair);
+      lowered = true;
+    } else {
+      args.push_back(cv.clone(part));
+    }
+  }
+  if (!lowered)
+    return;
+
+  auto *arg = util::makeTuple(args, M);
+  auto *replacementFunc =
+      M->getOrRealizeMethod(M->getStringType(), "_cat_fmt", {arg->getType()});
+  if (!replacementFunc)
+    return;
+  v->replaceAll(util::call(replacementFunc, {arg}));
+}
+
+const std::string StrSplitFieldOptimization::KEY =
+    "core-pythonic-str-split-field-opt";
+
+void StrSplitFieldOptimization::handle(CallInstr *v) {
+  auto *M = v->getModule();
+
+  if (!util::getStdlibFunc(v->getCallee(), Module::GETITEM_MAGIC_NAME) ||
+      v->numArgs() != 2)
+    return;
+
+  auto *split = cast<CallInstr>(v->front());
+  auto *idx = cast<IntConst>(v->back());
+  if (!split || !idx || idx->getVal() < 0)
+    return;
+
+  if (!util::getStdlibFunc(split->getCallee(), "split") ||
+      !util::isCallOf(split, "split", 3, /*output=*/nullptr, /*method=*/true) ||
+      !isString(split->front()))
+    return;
+
+  // with maxsplit m >= 0, only fields before m are unaffected by it
+  auto *maxsplit = cast<IntConst>(split->back());
+  if (!maxsplit || (maxsplit->getVal() >= 0 && idx->getVal() >= maxsplit->getVal()))
+    return;
+
+  auto it = split->begin();
+  auto *self = *it++;
+  auto *sep = *it++;
+
+  auto *replacementFunc = M->getOrRealizeMethod(
+      M->getStringType(), "field", {self->getType(), M->getIntType(), sep->getType()});
+  if (!replacementFunc)
+    return;
+
+  util::CloneVisitor cv(M);
+  v->replaceAll(
+      util::call(replacementFunc, {cv.clone(self), cv.clone(idx), cv.clone(sep)}));
+}
+
+const std::string StrLoopAppendOptimization::KEY = "core-pythonic-str-loop-append-opt";
+
+void StrLoopAppendOptimization::handle(WhileFlow *v) { rewrite(v, nullptr); }
+
+void StrLoopAppendOptimization::handle(ForFlow *v) {
+  if (!v->isParallel())
+    rewrite(v, v->getVar());
+}
+
+void StrLoopAppendOptimization::handle(ImperativeForFlow *v) {
+  if (!v->isParallel())
+    rewrite(v, v->getVar());
+}
+
+void StrLoopAppendOptimization::rewrite(Flow *loop, Var *loopVar) {
+  auto *M = loop->getModule();
+  auto *parent = cast<BodiedFunc>(getParentFunc());
+  // loop must be a statement so the builder can be set up around it
+  if (!parent || !getParent<SeriesFlow>())
+    return;
+
+  StrAppendFinder finder;
+  loop->accept(finder);
+  std::vector<Var *> vars;
+  for (auto &e : finder.candidates) {
+    if (!finder.disqualified.count(e.first) &&
+        (!loopVar || loopVar->getId() != e.first))
+      vars.push_back(e.second);
+  }
+  if (vars.empty())
+    return;
+
+  StrAppendFuncChecker checker;
+  parent->accept(checker);
+  if (checker.hasTry)
+    return;
+  vars.erase(std::remove_if(vars.begin(), vars.end(),
+                            [&](Var *var) {
+                              return checker.addressTaken.count(var->getId()) > 0;
+                            }),
+             vars.end());
+  if (vars.empty())
+    return;
+  std::sort(vars.begin(), vars.end(),
+            [](Var *a, Var *b) { return a->getId() < b->getId(); });
+
+  auto *strType = M->getStringType();
+  auto *bufType = M->getOrRealizeType("strbuf", {}, "std.internal.types.strbuf");
+  if (!bufType)
+    return;
+  auto *fromFunc = M->getOrRealizeMethod(bufType, "_from", {strType});
+  auto *appendFunc = M->getOrRealizeMethod(bufType, "append", {bufType, strType});
+  auto *finishFunc = M->getOrRealizeMethod(bufType, "_finish", {bufType});
+  if (!fromFunc || !appendFunc || !finishFunc)
+    return;
+
+  // convert:
+  //   loop:
+  //     s = s + a
+  // into:
+  //   buf = strbuf._from(s)
+  //   loop:
+  //     buf.append(a)
+  //   s = buf._finish()
+  StrAppendReplacer replacer(appendFunc);
+  for (auto *var : vars) {
+    auto *buf = M->Nr<Var>(bufType);
+    parent->push_back(buf);
+    insertBefore(M->Nr<AssignInstr>(buf, util::call(fromFunc, {M->Nr<VarValue>(var)})));
+    replacer.buffers[var->getId()] = buf;
+  }
+  loop->accept(replacer);
+  for (auto it = vars.rbegin(); it != vars.rend(); ++it) {
+    auto *buf = replacer.buffers[(*it)->getId()];
+    insertAfter(M->Nr<AssignInstr>(*it, util::call(finishFunc, {M->Nr<VarValue>(buf)})));
+  }
+}
+
 } // namespace pythonic
 } // namespace transform
 } // namespace ir
@@ -17,6 +17,44 @@ public:
   void handle(CallInstr *v) override;
 };
 
+/// Pass to lower f-strings, i.e. str.cat(...) over literals, str(x) and
+/// x.__format__("spec") for int, float and str "x", into a single call
+/// that formats every part straight into one pre-sized buffer. Format
+/// specs are checked at compile time; invalid ones are left untouched.
+class StrFormatOptimization : public OperatorPass {
+public:
+  static const std::string KEY;
+  std::string getKey() const override { return KEY; }
+  void handle(CallInstr *v) override;
+};
+
+/// Pass to replace s.split(sep)[k], for constant k >= 0, with
+/// s.field(k, sep), which stops scanning after field k and does not
+/// build the intermediate list.
+class StrSplitFieldOptimization : public OperatorPass {
+public:
+  static const std::string KEY;
+  std::string getKey() const override { return KEY; }
+  void handle(CallInstr *v) override;
+};
+
+/// Pass to replace loop-carried "s += x" on a local str variable with
+/// appends to a string builder that is converted back to str once after
+/// the loop, so building a string in a loop takes linear time. Applies
+/// when the loop reads "s" only through such updates and the enclosing
+/// function has no exception handlers that could observe it mid-loop.
+class StrLoopAppendOptimization : public OperatorPass {
+public:
+  static const std::string KEY;
+  std::string getKey() const override { return KEY; }
+  void handle(WhileFlow *v) override;
+  void handle(ForFlow *v) override;
+  void handle(ImperativeForFlow *v) override;
+
+private:
+  void rewrite(Flow *loop, Var *loopVar);
+};
+
 } // namespace pythonic
 } // namespace transform
 } // namespace ir
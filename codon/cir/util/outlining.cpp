@@ -377,7 +377,8 @@ struct Outliner : public Operator {
       it = flowRegion->insert(it, outlinedCall);
     }
 
-    return {outlinedFunc, outlinedCall, argKinds, static_cast<int>(outFlows.size())};
+    return {outlinedFunc, outlinedCall, argKinds, static_cast<int>(outFlows.size()),
+            outFlows};
   }
 };
 
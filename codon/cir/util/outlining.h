@@ -40,6 +40,11 @@ struct OutlineResult {
   /// the function returns void and no such checks are done.
   int numOutFlows = 0;
 
+  /// The externally-handled control flows themselves (copies of the
+  /// originals, as placed at the call site). Code i + 1 returned by the
+  /// outlined function corresponds to element i.
+  std::vector<Value *> outFlows;
+
   operator bool() const { return bool(func); }
 };
 
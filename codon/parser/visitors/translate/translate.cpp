@@ -448,7 +448,11 @@ void TranslateVisitor::visit(ForStmt *stmt) {
     int64_t collapse =
         fc->funcGenerics[2].type->getStatic()->expr->staticValue.getInt();
     bool gpu = fc->funcGenerics[3].type->getStatic()->expr->staticValue.getInt();
-    os = std::make_unique<OMPSched>(schedule, threads, chunk, ordered, collapse, gpu);
+    auto procBind =
+        fc->funcGenerics[4].type->getStatic()->expr->staticValue.getString();
+    auto places = fc->funcGenerics[5].type->getStatic()->expr->staticValue.getString();
+    os = std::make_unique<OMPSched>(schedule, threads, chunk, ordered, collapse, gpu,
+                                    procBind, places);
   }
 
   seqassert(stmt->var->getId(), "expected IdExpr, got {}", stmt->var);
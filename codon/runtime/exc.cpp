@@ -108,6 +108,9 @@ static uint64_t genClass(const unsigned char classChars[], size_t classCharsSize
 
 static uint64_t ourBaseExceptionClass = 0;
 
+// exception most recently delivered to a matching handler on this thread
+static thread_local _Unwind_Exception *caughtException = nullptr;
+
 struct OurExceptionType_t {
   int type;
 };
@@ -282,6 +285,11 @@ SEQ_FUNC void seq_throw(void *exc) {
   seq_terminate(exc);
 }
 
+// Returns the exception being handled by the calling except block, which can
+// be passed to seq_throw again, e.g. on another thread. Caught exceptions are
+// left to the GC rather than deleted, so it stays valid.
+SEQ_FUNC void *seq_exc_caught() { return caughtException; }
+
 static uintptr_t readULEB128(const uint8_t **data) {
   uintptr_t result = 0;
   uintptr_t shift = 0;
@@ -566,6 +574,7 @@ static _Unwind_Reason_Code handleLsda(int version, const uint8_t *lsda,
           // passed here.
           _Unwind_SetGR(context, __builtin_eh_return_data_regno(1),
                         (uintptr_t)actionValue);
+          caughtException = exceptionObject;
         }
 
         // To execute landing pad set here
@@ -1,9 +1,11 @@
 // Copyright (C) 2022-2024 Exaloop Inc. <https://exaloop.io>
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <chrono>
 #include <climits>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
@@ -17,6 +19,7 @@
 #include <sstream>
 #include <string>
 #include <thread>
+#include <type_traits>
 #include <unistd.h>
 #include <unwind.h>
 #include <vector>
@@ -153,14 +156,73 @@ SEQ_FUNC char **seq_env() { return environ; }
  */
 #define USE_STANDARD_MALLOC 0
 
+#if !USE_STANDARD_MALLOC
+// Boehm's thread-local free lists only cover small objects; anything past
+// a few hundred bytes takes the global allocation lock on every call, which
+// threads of a parallel loop building lists or dicts end up queueing on.
+// Mid-sized objects are instead handed out from per-thread lists, one per
+// size class, refilled a heap block at a time by GC_malloc_many().
+static constexpr size_t ALLOC_CACHE_GRANULE = 64;
+static constexpr size_t ALLOC_CACHE_MIN = 512; // smaller sizes use Boehm's lists
+static constexpr size_t ALLOC_CACHE_MAX = 2048; // GC_malloc_many() limit
+static constexpr size_t ALLOC_CACHE_CLASSES = ALLOC_CACHE_MAX / ALLOC_CACHE_GRANULE;
+
+struct AllocCache {
+  // uncollectable, so the collector scans it and keeps the cached objects
+  void **lists = nullptr;
+
+  void release() {
+    if (lists)
+      GC_FREE(lists);
+    lists = nullptr;
+  }
+
+  // threads that unregister from the collector release the cache first
+  ~AllocCache() { release(); }
+};
+
+static thread_local AllocCache allocCache;
+
+static void *cached_alloc(size_t n) {
+  auto *&lists = allocCache.lists;
+  if (!lists) {
+    lists = (void **)GC_MALLOC_UNCOLLECTABLE(ALLOC_CACHE_CLASSES * sizeof(void *));
+    if (!lists)
+      return GC_MALLOC(n);
+  }
+
+  auto c = (n - 1) / ALLOC_CACHE_GRANULE;
+  void *p = lists[c];
+  if (!p) {
+    p = GC_malloc_many((c + 1) * ALLOC_CACHE_GRANULE);
+    if (!p)
+      return GC_MALLOC(n); // let the collector report running out of memory
+  }
+  // objects come cleared apart from the link to the next one
+  lists[c] = GC_NEXT(p);
+  GC_NEXT(p) = nullptr;
+  return p;
+}
+#endif
+
 SEQ_FUNC void *seq_alloc(size_t n) {
 #if USE_STANDARD_MALLOC
   return malloc(n);
 #else
+  if (n > ALLOC_CACHE_MIN && n <= ALLOC_CACHE_MAX)
+    return cached_alloc(n);
   return GC_MALLOC(n);
 #endif
 }
 
+// Drops the calling thread's cached objects; must be called before the
+// thread unregisters from the collector.
+SEQ_FUNC void seq_alloc_cache_release() {
+#if !USE_STANDARD_MALLOC
+  allocCache.release();
+#endif
+}
+
 SEQ_FUNC void *seq_alloc_atomic(size_t n) {
 #if USE_STANDARD_MALLOC
   return malloc(n);
@@ -245,15 +307,89 @@ template <typename T> std::string default_format(T n) {
   return fmt::format(FMT_STRING("{}"), n);
 }
 
-template <> std::string default_format(double n) {
-  return fmt::format(FMT_STRING("{:g}"), n);
+// Numbers use dedicated routines that write into a small stack buffer rather
+// than going through fmt::format and a temporary std::string. NUM_CHARS_MAX
+// bounds the output of each: 20 for integers (sign plus 19 digits, or 20
+// digits unsigned) and well under 32 for doubles in "{:g}" form.
+static constexpr seq_int_t NUM_CHARS_MAX = 32;
+
+static const char digitPairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static seq_int_t uint_to_chars(uint64_t n, char *out) {
+  char tmp[20];
+  char *end = tmp + sizeof(tmp);
+  char *p = end;
+  while (n >= 100) {
+    auto r = (n % 100) * 2;
+    n /= 100;
+    p -= 2;
+    memcpy(p, digitPairs + r, 2);
+  }
+  if (n >= 10) {
+    p -= 2;
+    memcpy(p, digitPairs + n * 2, 2);
+  } else {
+    *--p = (char)('0' + n);
+  }
+  memcpy(out, p, end - p);
+  return end - p;
+}
+
+static seq_int_t int_to_chars(seq_int_t n, char *out) {
+  if (n < 0) {
+    *out = '-';
+    return 1 + uint_to_chars(0 - (uint64_t)n, out + 1);
+  }
+  return uint_to_chars((uint64_t)n, out);
+}
+
+static seq_int_t float_to_chars(double f, char *out) {
+  seq_int_t n = fmt::format_to_n(out, NUM_CHARS_MAX, FMT_STRING("{:g}"), f).size;
+  if (n == 4 && memcmp(out, "-nan", 4) == 0) {
+    memmove(out, out + 1, 3);
+    n = 3;
+  }
+  return n;
+}
+
+static seq_int_t num_to_chars(seq_int_t n, char *out) { return int_to_chars(n, out); }
+static seq_int_t num_to_chars(uint64_t n, char *out) { return uint_to_chars(n, out); }
+static seq_int_t num_to_chars(double f, char *out) { return float_to_chars(f, out); }
+
+static seq_str_t chars_conv(const char *p, seq_int_t n) {
+  auto *s = (char *)seq_alloc_atomic(n);
+  memcpy(s, p, n);
+  return {n, s};
+}
+
+template <typename T> seq_str_t default_conv(T n) {
+  if constexpr (std::is_same_v<T, seq_int_t> || std::is_same_v<T, uint64_t> ||
+                std::is_same_v<T, double>) {
+    char tmp[NUM_CHARS_MAX];
+    return chars_conv(tmp, num_to_chars(n, tmp));
+  } else {
+    return string_conv(default_format(n));
+  }
+}
+
+SEQ_FUNC seq_int_t seq_int_to_chars(seq_int_t n, char *buf) {
+  return int_to_chars(n, buf);
+}
+
+SEQ_FUNC seq_int_t seq_float_to_chars(double f, char *buf) {
+  return float_to_chars(f, buf);
 }
 
 template <typename T> seq_str_t fmt_conv(T n, seq_str_t format, bool *error) {
   *error = false;
   try {
     if (format.len == 0) {
-      return string_conv(default_format(n));
+      return default_conv(n);
     } else {
       std::string fstr(format.str, format.len);
       return string_conv(
@@ -286,6 +422,59 @@ SEQ_FUNC seq_str_t seq_str_str(seq_str_t s, seq_str_t format, bool *error) {
   return fmt_conv(t, format, error);
 }
 
+template <typename T> seq_int_t default_format_to(T n, char *buf, seq_int_t cap) {
+  if constexpr (std::is_same_v<T, seq_int_t> || std::is_same_v<T, double>) {
+    if (cap >= NUM_CHARS_MAX)
+      return num_to_chars(n, buf);
+    char tmp[NUM_CHARS_MAX];
+    auto len = num_to_chars(n, tmp);
+    memcpy(buf, tmp, std::min(len, cap));
+    return len;
+  } else {
+    return (seq_int_t)fmt::format_to_n(buf, (size_t)cap, FMT_STRING("{}"), n).size;
+  }
+}
+
+// Formats directly into the caller's buffer. "format" is either empty (default
+// formatting) or a complete replacement field such as "{:>8.3f}", built by the
+// compiler from a constant format spec. Returns the number of bytes the output
+// needs, which may exceed "cap", in which case only "cap" bytes are written.
+template <typename T>
+seq_int_t fmt_conv_to(T n, seq_str_t format, char *buf, seq_int_t cap, bool *error) {
+  *error = false;
+  try {
+    if (format.len == 0)
+      return default_format_to(n, buf, cap);
+    return (seq_int_t)fmt::format_to_n(
+               buf, (size_t)cap,
+               fmt::runtime(fmt::string_view(format.str, (size_t)format.len)), n)
+        .size;
+  } catch (const std::runtime_error &) {
+    *error = true;
+    return 0;
+  }
+}
+
+SEQ_FUNC seq_int_t seq_str_int_to(seq_int_t n, seq_str_t format, char *buf,
+                                   seq_int_t cap, bool *error) {
+  return fmt_conv_to<seq_int_t>(n, format, buf, cap, error);
+}
+
+SEQ_FUNC seq_int_t seq_str_float_to(double f, seq_str_t format, char *buf,
+                                     seq_int_t cap, bool *error) {
+  auto n = fmt_conv_to<double>(f, format, buf, cap, error);
+  if (n == 4 && cap >= 4 && memcmp(buf, "-nan", 4) == 0) {
+    memmove(buf, buf + 1, 3);
+    n = 3;
+  }
+  return n;
+}
+
+SEQ_FUNC seq_int_t seq_str_str_to(seq_str_t s, seq_str_t format, char *buf,
+                                   seq_int_t cap, bool *error) {
+  return fmt_conv_to(fmt::string_view(s.str, (size_t)s.len), format, buf, cap, error);
+}
+
 SEQ_FUNC seq_int_t seq_int_from_str(seq_str_t s, const char **e, int base) {
   seq_int_t result;
   auto r = fast_float::from_chars(s.str, s.str + s.len, result, base);
@@ -300,6 +489,165 @@ SEQ_FUNC double seq_float_from_str(seq_str_t s, const char **e) {
   return result;
 }
 
+/*
+ * Bulk numeric parsing
+ */
+
+// SWAR helpers for eight ASCII digits loaded as a little-endian word.
+static bool is_eight_digits(uint64_t w) {
+  return !(((w + 0x4646464646464646) | (w - 0x3030303030303030)) & 0x8080808080808080);
+}
+
+static uint64_t parse_eight_digits(uint64_t w) {
+  const uint64_t mask = 0x000000FF000000FF;
+  const uint64_t mul1 = 0x000F424000000064; // 100 + (1000000 << 32)
+  const uint64_t mul2 = 0x0000271000000001; // 1 + (10000 << 32)
+  w -= 0x3030303030303030;
+  w = (w * 10) + (w >> 8);
+  return (((w & mask) * mul1) + (((w >> 16) & mask) * mul2)) >> 32;
+}
+
+static bool is_inline_space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+static bool is_space(char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r'); // \t \n \v \f \r
+}
+
+// Parses an optionally signed decimal integer, eight digits at a time where
+// possible. Returns null if there are no digits or the value overflows.
+static const char *parse_int(const char *p, const char *end, seq_int_t &out) {
+  bool neg = false;
+  if (p < end && (*p == '-' || *p == '+'))
+    neg = (*p++ == '-');
+  const char *start = p;
+  uint64_t v = 0;
+  bool overflow = false;
+  while (end - p >= 8) {
+    uint64_t w;
+    memcpy(&w, p, 8);
+    if (!is_eight_digits(w))
+      break;
+    overflow |= __builtin_mul_overflow(v, (uint64_t)100000000, &v) ||
+                __builtin_add_overflow(v, parse_eight_digits(w), &v);
+    p += 8;
+  }
+  while (p < end && *p >= '0' && *p <= '9') {
+    overflow |= __builtin_mul_overflow(v, (uint64_t)10, &v) ||
+                __builtin_add_overflow(v, (uint64_t)(*p - '0'), &v);
+    ++p;
+  }
+  if (p == start || overflow || v > (uint64_t)INT64_MAX + neg)
+    return nullptr;
+  out = neg ? (seq_int_t)(0 - v) : (seq_int_t)v;
+  return p;
+}
+
+static const char *parse_num(const char *p, const char *end, seq_int_t &out) {
+  return parse_int(p, end, out);
+}
+
+static const char *parse_num(const char *p, const char *end, double &out) {
+  auto r = fast_float::from_chars(p, end, out);
+  return (r.ec == std::errc() || r.ec == std::errc::result_out_of_range) ? r.ptr
+                                                                         : nullptr;
+}
+
+// Parses up to "cap" numbers from "s" into "out", starting at offset "*pos".
+// Fields are separated by "sep" or newlines, or by any whitespace if "sep" is
+// zero; spaces around fields and blank lines are ignored. On return, "*pos" is
+// the offset at which parsing stopped: the end of "s" once all input has been
+// consumed, or the start of the offending field if "*error" was set.
+template <typename T>
+static seq_int_t parse_many(seq_str_t s, char sep, T *out, seq_int_t cap,
+                            seq_int_t *pos, bool *error) {
+  const char *p = s.str + *pos, *end = s.str + s.len;
+  seq_int_t n = 0;
+  *error = false;
+  while (n < cap) {
+    while (p < end && is_space(*p))
+      ++p;
+    if (p == end)
+      break;
+    const char *field = p;
+    const char *q = parse_num(p, end, out[n]);
+    if (!q || (q < end && !is_space(*q) && !(sep && *q == sep))) {
+      p = field;
+      *error = true;
+      break;
+    }
+    ++n;
+    p = q;
+    while (p < end && is_inline_space(*p))
+      ++p;
+    if (sep && p < end && *p == sep) {
+      // a separator must be followed by another field on the same line
+      const char *next = p + 1;
+      while (next < end && is_inline_space(*next))
+        ++next;
+      if (next == end || *next == '\n' || *next == sep) {
+        p = next;
+        *error = true;
+        break;
+      }
+      p = next;
+    }
+  }
+  *pos = p - s.str;
+  return n;
+}
+
+SEQ_FUNC seq_int_t seq_parse_ints(seq_str_t s, char sep, seq_int_t *out, seq_int_t cap,
+                                  seq_int_t *pos, bool *error) {
+  return parse_many(s, sep, out, cap, pos, error);
+}
+
+SEQ_FUNC seq_int_t seq_parse_floats(seq_str_t s, char sep, double *out, seq_int_t cap,
+                                    seq_int_t *pos, bool *error) {
+  return parse_many(s, sep, out, cap, pos, error);
+}
+
+// Parses integers stored in consecutive fields of exactly "width" bytes, right
+// aligned with optional leading spaces; line breaks between fields are skipped.
+// Zero-padded fields of up to eight bytes are decoded with a single SWAR step.
+// "*pos" and "*error" behave as in parse_many().
+SEQ_FUNC seq_int_t seq_parse_fixed_ints(seq_str_t s, seq_int_t width, seq_int_t *out,
+                                        seq_int_t cap, seq_int_t *pos, bool *error) {
+  const char *p = s.str + *pos, *end = s.str + s.len;
+  seq_int_t n = 0;
+  *error = false;
+  while (n < cap) {
+    while (p < end && (*p == '\n' || *p == '\r'))
+      ++p;
+    if (p == end)
+      break;
+    if (end - p < width) {
+      *error = true;
+      break;
+    }
+    if (width <= 8) {
+      uint64_t w = 0x3030303030303030;
+      memcpy((char *)&w + (8 - width), p, width);
+      if (is_eight_digits(w)) {
+        out[n++] = (seq_int_t)parse_eight_digits(w);
+        p += width;
+        continue;
+      }
+    }
+    const char *f = p, *fend = p + width;
+    while (f < fend && *f == ' ')
+      ++f;
+    const char *q = parse_int(f, fend, out[n]);
+    if (!q || q != fend) {
+      *error = true;
+      break;
+    }
+    ++n;
+    p = fend;
+  }
+  *pos = p - s.str;
+  return n;
+}
+
 /*
  * General I/O
  */
@@ -391,3 +739,37 @@ SEQ_FUNC void seq_rlock_release(void *lock) {
   auto *m = (std::recursive_timed_mutex *)lock;
   m->unlock();
 }
+
+SEQ_FUNC void seq_thread_start(void (*fn)(void *), void *arg) {
+  // arg is not visible to the collector from inside std::thread, so wait
+  // until the new thread has registered itself and holds arg on its stack
+  std::mutex m;
+  std::condition_variable cv;
+  bool started = false;
+
+  std::thread([&m, &cv, &started, fn, arg]() {
+    GC_stack_base sb;
+    GC_get_stack_base(&sb);
+    GC_register_my_thread(&sb);
+    void *data = arg;
+    {
+      std::lock_guard<std::mutex> lock(m);
+      started = true;
+      cv.notify_one();
+    }
+    fn(data);
+    seq_alloc_cache_release();
+    GC_unregister_my_thread();
+  }).detach();
+
+  std::unique_lock<std::mutex> lock(m);
+  cv.wait(lock, [&started] { return started; });
+}
+
+// The tasks module's scheduler of the team the calling thread works for.
+// Not a GC root: the pool is kept alive by the frame of tasks.run().
+static thread_local void *taskPool = nullptr;
+
+SEQ_FUNC void *seq_task_pool() { return taskPool; }
+
+SEQ_FUNC void seq_set_task_pool(void *pool) { taskPool = pool; }
@@ -55,6 +55,7 @@ SEQ_FUNC char **seq_env();
 SEQ_FUNC void seq_assert_failed(seq_str_t file, seq_int_t line);
 
 SEQ_FUNC void *seq_alloc(size_t n);
+SEQ_FUNC void seq_alloc_cache_release();
 SEQ_FUNC void *seq_alloc_atomic(size_t n);
 SEQ_FUNC void *seq_alloc_uncollectable(size_t n);
 SEQ_FUNC void *seq_alloc_atomic_uncollectable(size_t n);
@@ -69,6 +70,7 @@ SEQ_FUNC void seq_gc_exclude_static_roots(void *start, void *end);
 
 SEQ_FUNC void *seq_alloc_exc(int type, void *obj);
 SEQ_FUNC void seq_throw(void *exc);
+SEQ_FUNC void *seq_exc_caught();
 SEQ_FUNC _Unwind_Reason_Code seq_personality(int version, _Unwind_Action actions,
                                              uint64_t exceptionClass,
                                              _Unwind_Exception *exceptionObject,
@@ -81,6 +83,20 @@ SEQ_FUNC seq_str_t seq_str_uint(seq_int_t n, seq_str_t format, bool *error);
 SEQ_FUNC seq_str_t seq_str_float(double f, seq_str_t format, bool *error);
 SEQ_FUNC seq_str_t seq_str_ptr(void *p, seq_str_t format, bool *error);
 SEQ_FUNC seq_str_t seq_str_str(seq_str_t s, seq_str_t format, bool *error);
+SEQ_FUNC seq_int_t seq_int_to_chars(seq_int_t n, char *buf);
+SEQ_FUNC seq_int_t seq_float_to_chars(double f, char *buf);
+SEQ_FUNC seq_int_t seq_str_int_to(seq_int_t n, seq_str_t format, char *buf,
+                                   seq_int_t cap, bool *error);
+SEQ_FUNC seq_int_t seq_str_float_to(double f, seq_str_t format, char *buf,
+                                     seq_int_t cap, bool *error);
+SEQ_FUNC seq_int_t seq_str_str_to(seq_str_t s, seq_str_t format, char *buf,
+                                   seq_int_t cap, bool *error);
+SEQ_FUNC seq_int_t seq_parse_ints(seq_str_t s, char sep, seq_int_t *out, seq_int_t cap,
+                                  seq_int_t *pos, bool *error);
+SEQ_FUNC seq_int_t seq_parse_floats(seq_str_t s, char sep, double *out, seq_int_t cap,
+                                    seq_int_t *pos, bool *error);
+SEQ_FUNC seq_int_t seq_parse_fixed_ints(seq_str_t s, seq_int_t width, seq_int_t *out,
+                                        seq_int_t cap, seq_int_t *pos, bool *error);
 
 SEQ_FUNC void *seq_stdin();
 SEQ_FUNC void *seq_stdout();
@@ -96,6 +112,9 @@ SEQ_FUNC void seq_lock_release(void *lock);
 SEQ_FUNC void *seq_rlock_new();
 SEQ_FUNC bool seq_rlock_acquire(void *lock, bool block, double timeout);
 SEQ_FUNC void seq_rlock_release(void *lock);
+SEQ_FUNC void seq_thread_start(void (*fn)(void *), void *arg);
+SEQ_FUNC void *seq_task_pool();
+SEQ_FUNC void seq_set_task_pool(void *pool);
 
 namespace codon {
 namespace runtime {
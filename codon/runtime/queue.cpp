@@ -0,0 +1,259 @@
+// Copyright (C) 2022-2024 Exaloop Inc. <https://exaloop.io>
+
+#include "codon/runtime/lib.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
+
+/*
+ * Bounded multi-producer, multi-consumer queues, used for threading's
+ * BoundedQueue and Channel.
+ *
+ * Pushes and pops follow Vyukov's bounded queue: each cell carries a
+ * sequence number saying whether it is free for the current lap, and
+ * positions are claimed with a CAS, so neither side ever takes a lock.
+ * Threads that find the queue full (or empty) spin briefly and then
+ * sleep on a condition variable, which is only signalled when somebody
+ * is actually asleep. select() sleeps on a shared condition variable
+ * that every queue signals while there are selecting threads.
+ *
+ * Closing sets the top bit of tail, so a push either claims its position
+ * before the close or fails its CAS and sees the bit. A closed queue is
+ * drained once head catches up with the (now fixed) tail.
+ */
+
+namespace {
+enum Status : seq_int_t { OK = 0, TIMEOUT = 1, CLOSED = 2 };
+
+constexpr int SPINS = 32;
+constexpr size_t LINE = 64;
+constexpr size_t CLOSED_BIT = ~(~size_t(0) >> 1);
+
+struct Queue {
+  std::atomic<size_t> head; // next position to pop
+  char pad0[LINE - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> tail; // next position to push, plus CLOSED_BIT
+  char pad1[LINE - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> *seq;
+  char *data;
+  size_t cap;
+  size_t elemSize;
+  std::atomic<int> sleepers;
+  std::mutex m;
+  std::condition_variable cv;
+
+  char *slot(size_t pos) { return data + (pos % cap) * elemSize; }
+
+  Status tryPush(const void *x) {
+    size_t pos = tail.load(std::memory_order_relaxed);
+    while (true) {
+      if (pos & CLOSED_BIT)
+        return CLOSED;
+      auto &s = seq[pos % cap];
+      auto dif = (intptr_t)s.load(std::memory_order_acquire) - (intptr_t)pos;
+      if (dif == 0) {
+        // fails if the queue was closed since we loaded pos
+        if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          std::memcpy(slot(pos), x, elemSize);
+          s.store(pos + 1, std::memory_order_release);
+          return OK;
+        }
+      } else if (dif < 0) {
+        return TIMEOUT; // full
+      } else {
+        pos = tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool tryPop(void *out) {
+    size_t pos = head.load(std::memory_order_relaxed);
+    while (true) {
+      auto &s = seq[pos % cap];
+      auto dif = (intptr_t)s.load(std::memory_order_acquire) - (intptr_t)(pos + 1);
+      if (dif == 0) {
+        if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          std::memcpy(out, slot(pos), elemSize);
+          std::memset(slot(pos), 0, elemSize); // don't keep the item alive
+          s.store(pos + cap, std::memory_order_release);
+          return true;
+        }
+      } else if (dif < 0) {
+        return false; // empty
+      } else {
+        pos = head.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  size_t size() const {
+    auto h = head.load(std::memory_order_acquire);
+    auto t = tail.load(std::memory_order_acquire) & ~CLOSED_BIT;
+    return t > h ? t - h : 0;
+  }
+
+  bool isClosed() const { return tail.load(std::memory_order_acquire) & CLOSED_BIT; }
+
+  void close() { tail.fetch_or(CLOSED_BIT, std::memory_order_acq_rel); }
+
+  // Status of a pop that found no item: CLOSED once the queue is closed and
+  // every push that got in before the close has been popped. A push can
+  // have claimed its position but not yet published the item; it will wake
+  // us when it has.
+  Status emptyStatus() const {
+    auto t = tail.load(std::memory_order_acquire);
+    if (!(t & CLOSED_BIT))
+      return TIMEOUT;
+    return head.load(std::memory_order_acquire) >= (t & ~CLOSED_BIT) ? CLOSED
+                                                                       : TIMEOUT;
+  }
+};
+
+// shared by all threads blocked in select()
+std::mutex selectMutex;
+std::condition_variable selectCV;
+std::atomic<int> selectSleepers{0};
+
+void wakeSelectors() {
+  if (selectSleepers.load(std::memory_order_relaxed) > 0) {
+    std::lock_guard<std::mutex> lock(selectMutex);
+    selectCV.notify_all();
+  }
+}
+
+void wake(Queue *q) {
+  // pairs with the fence in sleep(), so that either the sleeper sees our
+  // change when it checks again or we see the sleeper
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (q->sleepers.load(std::memory_order_relaxed) > 0) {
+    std::lock_guard<std::mutex> lock(q->m);
+    q->cv.notify_all();
+  }
+  wakeSelectors();
+}
+
+using Clock = std::chrono::steady_clock;
+
+Clock::time_point deadline(double timeout) {
+  return Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                            std::chrono::duration<double>(timeout));
+}
+
+// Runs attempt() until it returns a status other than TIMEOUT, sleeping on
+// cv in between; gives up after timeout seconds, or never if timeout < 0.
+template <typename F>
+Status waitUntil(std::mutex &m, std::condition_variable &cv, std::atomic<int> &sleepers,
+                 double timeout, F attempt) {
+  for (int i = 0; i < SPINS; i++) {
+    auto s = attempt();
+    if (s != TIMEOUT || timeout == 0.0)
+      return s;
+    std::this_thread::yield();
+  }
+
+  auto until = deadline(timeout);
+  sleepers.fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  Status s = TIMEOUT;
+  {
+    std::unique_lock<std::mutex> lock(m);
+    while ((s = attempt()) == TIMEOUT) {
+      if (timeout < 0.0) {
+        cv.wait(lock);
+      } else if (cv.wait_until(lock, until) == std::cv_status::timeout) {
+        s = attempt();
+        break;
+      }
+    }
+  }
+  sleepers.fetch_sub(1);
+  return s;
+}
+} // namespace
+
+SEQ_FUNC void *seq_queue_new(seq_int_t capacity, seq_int_t elemSize, bool atomic) {
+  auto cap = (size_t)(capacity > 0 ? capacity : 1);
+  // the queue is scanned so that it keeps its buffers alive; items are only
+  // scanned if they can hold pointers
+  auto *q = new (seq_alloc(sizeof(Queue))) Queue();
+  q->seq = (std::atomic<size_t> *)seq_alloc_atomic(cap * sizeof(std::atomic<size_t>));
+  for (size_t i = 0; i < cap; i++)
+    new (&q->seq[i]) std::atomic<size_t>(i);
+  auto bytes = cap * (size_t)elemSize;
+  q->data = (char *)(atomic ? seq_alloc_atomic(bytes) : seq_alloc(bytes));
+  q->cap = cap;
+  q->elemSize = (size_t)elemSize;
+  q->head.store(0);
+  q->tail.store(0);
+  q->sleepers.store(0);
+  return q;
+}
+
+SEQ_FUNC seq_int_t seq_queue_push(void *queue, void *x, double timeout) {
+  auto *q = (Queue *)queue;
+  auto s = waitUntil(q->m, q->cv, q->sleepers, timeout,
+                     [&]() { return q->tryPush(x); });
+  if (s == OK)
+    wake(q);
+  return s;
+}
+
+SEQ_FUNC seq_int_t seq_queue_pop(void *queue, void *out, double timeout) {
+  auto *q = (Queue *)queue;
+  auto s = waitUntil(q->m, q->cv, q->sleepers, timeout, [&]() {
+    // closed queues are still drained
+    return q->tryPop(out) ? OK : q->emptyStatus();
+  });
+  if (s == OK)
+    wake(q);
+  return s;
+}
+
+SEQ_FUNC void seq_queue_close(void *queue) {
+  auto *q = (Queue *)queue;
+  q->close();
+  wake(q);
+}
+
+SEQ_FUNC bool seq_queue_closed(void *queue) {
+  return ((Queue *)queue)->isClosed();
+}
+
+SEQ_FUNC seq_int_t seq_queue_len(void *queue) { return ((Queue *)queue)->size(); }
+
+SEQ_FUNC seq_int_t seq_queue_capacity(void *queue) { return ((Queue *)queue)->cap; }
+
+// Pops from the first ready queue of queues[0:n], trying them from a
+// rotating start so that none is starved. Returns the queue's index,
+// -2 - index if that queue is closed and drained, or -1 on timeout.
+SEQ_FUNC seq_int_t seq_queue_select(void **queues, seq_int_t n, void *out,
+                                    double timeout) {
+  static thread_local size_t start = 0;
+  seq_int_t found = -1;
+  auto s = waitUntil(selectMutex, selectCV, selectSleepers, timeout, [&]() {
+    for (seq_int_t k = 0; k < n; k++) {
+      auto i = (seq_int_t)((start + k) % n);
+      auto *q = (Queue *)queues[i];
+      if (q->tryPop(out)) {
+        found = i;
+        return OK;
+      }
+      if (q->emptyStatus() == CLOSED) {
+        found = -2 - i;
+        return CLOSED;
+      }
+    }
+    return TIMEOUT;
+  });
+  start++;
+  if (s == TIMEOUT)
+    return -1;
+  if (found >= 0)
+    wake((Queue *)queues[found]);
+  return found;
+}
@@ -1,8 +1,10 @@
 // Copyright (C) 2022-2024 Exaloop Inc. <https://exaloop.io>
 
 #include "codon/runtime/lib.h"
+#include <algorithm>
 #include <cstring>
 #include <re2/re2.h>
+#include <re2/set.h>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -130,34 +132,48 @@ static inline Regex *get(const seq_str_t &p, seq_int_t flags) {
  * Matching
  */
 
-SEQ_FUNC Span *seq_re_match(Regex *re, seq_int_t anchor, seq_str_t s, seq_int_t pos,
-                            seq_int_t endpos) {
-  const int num_groups = re->NumberOfCapturingGroups() + 1; // need $0
-  std::vector<StringPiece> groups;
-  groups.resize(num_groups);
-
-  if (!re->Match(str2sp(s), pos, endpos, static_cast<Regex::Anchor>(anchor),
-                 groups.data(), groups.size())) {
-    // Ensure that groups are null before converting to spans!
-    for (auto &it : groups) {
-      it = StringPiece();
-    }
+// Matches into a caller-provided span buffer with room for "nspans" spans,
+// i.e. the pattern's capturing groups plus one for $0. Small group counts use
+// a buffer on the stack; larger ones reuse a per-thread buffer.
+static bool match_into(Regex *re, seq_int_t anchor, seq_str_t s, seq_int_t pos,
+                       seq_int_t endpos, Span *spans, seq_int_t nspans) {
+  static constexpr seq_int_t MAX_STACK_GROUPS = 16;
+  static thread_local std::vector<StringPiece> heapGroups;
+  StringPiece stackGroups[MAX_STACK_GROUPS];
+  StringPiece *groups = stackGroups;
+  if (nspans > MAX_STACK_GROUPS) {
+    heapGroups.assign(nspans, StringPiece());
+    groups = heapGroups.data();
   }
 
-  auto *spans = (Span *)seq_alloc_atomic(num_groups * sizeof(Span));
-  unsigned i = 0;
-  for (const auto &it : groups) {
-    if (it.data() == nullptr) {
-      spans[i++] = {-1, -1};
+  bool matched = re->Match(str2sp(s), pos, endpos, static_cast<Regex::Anchor>(anchor),
+                           groups, static_cast<int>(nspans));
+  for (seq_int_t i = 0; i < nspans; i++) {
+    const auto &it = groups[i];
+    if (!matched || it.data() == nullptr) {
+      spans[i] = {-1, -1};
     } else {
-      spans[i++] = {static_cast<seq_int_t>(it.data() - s.str),
-                    static_cast<seq_int_t>(it.data() - s.str + it.size())};
+      spans[i] = {static_cast<seq_int_t>(it.data() - s.str),
+                  static_cast<seq_int_t>(it.data() - s.str + it.size())};
     }
   }
+  return matched;
+}
 
+SEQ_FUNC Span *seq_re_match(Regex *re, seq_int_t anchor, seq_str_t s, seq_int_t pos,
+                            seq_int_t endpos) {
+  const int num_groups = re->NumberOfCapturingGroups() + 1; // need $0
+  auto *spans = (Span *)seq_alloc_atomic(num_groups * sizeof(Span));
+  match_into(re, anchor, s, pos, endpos, spans, num_groups);
   return spans;
 }
 
+SEQ_FUNC bool seq_re_match_into(Regex *re, seq_int_t anchor, seq_str_t s,
+                                seq_int_t pos, seq_int_t endpos, Span *spans,
+                                seq_int_t nspans) {
+  return match_into(re, anchor, s, pos, endpos, spans, nspans);
+}
+
 SEQ_FUNC Span seq_re_match_one(Regex *re, seq_int_t anchor, seq_str_t s, seq_int_t pos,
                                seq_int_t endpos) {
   StringPiece m;
@@ -178,8 +194,67 @@ SEQ_FUNC seq_str_t seq_re_escape(seq_str_t p) {
 
 SEQ_FUNC Regex *seq_re_compile(seq_str_t p, seq_int_t flags) { return get(p, flags); }
 
+// Compiles a string-literal pattern into a compiler-generated global slot.
+// The regex is shared by all threads and lives for the rest of the program,
+// so it is not affected by purge(). If several threads race on the first
+// use, one regex wins and the others are discarded. Patterns that fail to
+// compile are left to the cache instead, so a non-null slot always holds a
+// valid regex.
+SEQ_FUNC Regex *seq_re_compile_static(Regex **slot, seq_str_t p, seq_int_t flags) {
+  if (auto *re = __atomic_load_n(slot, __ATOMIC_ACQUIRE))
+    return re;
+  auto *re = new Regex(str2sp(p), flags2opt(flags));
+  if (!re->ok()) {
+    delete re;
+    return get(p, flags);
+  }
+  Regex *expected = nullptr;
+  if (__atomic_compare_exchange_n(slot, &expected, re, /*weak=*/false,
+                                  __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    return re;
+  delete re;
+  return expected;
+}
+
 SEQ_FUNC void seq_re_purge() { cache.clear(); }
 
+/*
+ * Pattern sets
+ */
+
+SEQ_FUNC re2::RE2::Set *seq_re_set_new(seq_int_t flags, seq_int_t anchor) {
+  return new re2::RE2::Set(flags2opt(flags), static_cast<Regex::Anchor>(anchor));
+}
+
+SEQ_FUNC void seq_re_set_free(re2::RE2::Set *set) { delete set; }
+
+SEQ_FUNC seq_int_t seq_re_set_add(re2::RE2::Set *set, seq_str_t p, seq_str_t *error) {
+  std::string e;
+  int index = set->Add(str2sp(p), &e);
+  if (index < 0)
+    *error = convert(e);
+  return index;
+}
+
+SEQ_FUNC bool seq_re_set_compile(re2::RE2::Set *set) { return set->Compile(); }
+
+// Writes the sorted indices of matching patterns into "out", up to "cap" of
+// them, and returns how many patterns matched. A null "out" only tests for
+// any match, which avoids collecting indices altogether.
+SEQ_FUNC seq_int_t seq_re_set_match(re2::RE2::Set *set, seq_str_t s, seq_int_t *out,
+                                    seq_int_t cap) {
+  if (!out)
+    return set->Match(str2sp(s), nullptr) ? 1 : 0;
+  static thread_local std::vector<int> hits;
+  if (!set->Match(str2sp(s), &hits))
+    return 0;
+  std::sort(hits.begin(), hits.end());
+  seq_int_t n = hits.size();
+  for (seq_int_t i = 0; i < n && i < cap; i++)
+    out[i] = hits[i];
+  return n;
+}
+
 /*
  * Pattern methods
  */
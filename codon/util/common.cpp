@@ -78,6 +78,12 @@ void compilationWarning(const std::string &msg, const std::string &file, int lin
     exit(EXIT_FAILURE);
 }
 
+void compilationRemark(const std::string &msg, const std::string &file, int line,
+                       int col, MessageGroupPos pos) {
+  compilationMessage("\033[1;36mremark:\033[0m", msg, file, line, col, /*len=*/0,
+                     /*errorCode=*/-1, pos);
+}
+
 void Logger::parse(const std::string &s) {
   flags |= s.find('t') != std::string::npos ? FLAG_TIME : 0;
   flags |= s.find('r') != std::string::npos ? FLAG_REALIZE : 0;
@@ -165,6 +165,9 @@ void compilationWarning(const std::string &msg, const std::string &file = "",
                         int line = 0, int col = 0, int len = 0, int errorCode = -1,
                         bool terminate = false, MessageGroupPos pos = NONE);
 
+void compilationRemark(const std::string &msg, const std::string &file = "",
+                       int line = 0, int col = 0, MessageGroupPos pos = NONE);
+
 } // namespace codon
 
 template <> struct fmt::formatter<codon::SrcInfo> : fmt::ostream_formatter {};
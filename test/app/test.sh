@@ -18,3 +18,14 @@ gcc "$testdir/test.c" -L"$arg" -Wl,-rpath,"$arg" -lcodon_export_test -o "$arg/te
 
 # exit code test
 $codon run "$testdir/exit.codon" || if [[ $? -ne 42 ]]; then exit 4; fi
+
+# vectorization report test: remarks must point back into the source
+$codon build -release -vectorize-report -o "$arg/test_binary" "$testdir/vectorize.codon" 2>&1 \
+  | grep -q "vectorize.codon:[0-9]" || exit 5
+
+# LTO tests: executable with ThinLTO, shared library with full LTO
+$codon build -release -lto=thin -o "$arg/test_binary" "$testdir/build.codon"
+[ "$($arg/test_binary)" == "hello" ] || exit 6
+$codon build -release -lto=full -relocation-model=pic -o "$arg/libcodon_export_test.so" "$testdir/export.codon"
+gcc "$testdir/test.c" -L"$arg" -Wl,-rpath,"$arg" -lcodon_export_test -o "$arg/test_binary"
+[ "$($arg/test_binary)" == "abcabcabc" ] || exit 7
@@ -475,6 +475,11 @@ INSTANTIATE_TEST_SUITE_P(
         "stdlib/sort_test.codon",
         "stdlib/heapq_test.codon",
         "stdlib/operator_test.codon",
+        "stdlib/csv_test.codon",
+        "stdlib/numparse_test.codon",
+        "stdlib/utf8_test.codon",
+        "stdlib/parallel_test.codon",
+        "stdlib/threading_test.codon",
         "python/pybridge.codon"
       ),
       testing::Values(true, false),
@@ -490,6 +495,8 @@ INSTANTIATE_TEST_SUITE_P(
     OptTests, SeqTest,
     testing::Combine(
         testing::Values(
+            "transform/alloc_opt.codon",
+            "transform/bounds_opt.codon",
             "transform/canonical.codon",
             "transform/dict_opt.codon",
             "transform/escapes.codon",